@@ -0,0 +1,5 @@
+.junk/12term/base64.c.mk .junk/12term/src/base64.c.o: src/base64.c \
+ src/common.h src/debug.h src/base64.h
+src/common.h:
+src/debug.h:
+src/base64.h:
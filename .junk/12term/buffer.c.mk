@@ -0,0 +1,10 @@
+.junk/12term/buffer.c.mk .junk/12term/src/buffer.c.o: src/buffer.c \
+ src/common.h src/debug.h src/buffer.h src/ctlseqs.h src/image.h \
+ src/settings.h src/vt.h
+src/common.h:
+src/debug.h:
+src/buffer.h:
+src/ctlseqs.h:
+src/image.h:
+src/settings.h:
+src/vt.h:
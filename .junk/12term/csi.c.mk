@@ -0,0 +1,11 @@
+.junk/12term/csi.c.mk .junk/12term/src/csi.c.o: src/csi.c src/common.h \
+ src/debug.h src/ctlseqs2.h src/vt.h src/buffer.h src/ctlseqs.h \
+ src/buffer2.h src/image.h
+src/common.h:
+src/debug.h:
+src/ctlseqs2.h:
+src/vt.h:
+src/buffer.h:
+src/ctlseqs.h:
+src/buffer2.h:
+src/image.h:
@@ -0,0 +1,16 @@
+.junk/12term/ctlseqs.c.mk .junk/12term/src/ctlseqs.c.o: src/ctlseqs.c \
+ src/common.h src/debug.h src/ctlseqs.h src/ctlseqs2.h src/buffer.h \
+ src/buffer2.h src/settings.h src/vt.h src/scan.h src/kitty.h src/sixel.h \
+ src/base64.h
+src/common.h:
+src/debug.h:
+src/ctlseqs.h:
+src/ctlseqs2.h:
+src/buffer.h:
+src/buffer2.h:
+src/settings.h:
+src/vt.h:
+src/scan.h:
+src/kitty.h:
+src/sixel.h:
+src/base64.h:
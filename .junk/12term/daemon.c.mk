@@ -0,0 +1,7 @@
+.junk/12term/daemon.c.mk .junk/12term/src/daemon.c.o: src/daemon.c \
+ src/common.h src/debug.h src/daemon.h src/x.h src/loop.h
+src/common.h:
+src/debug.h:
+src/daemon.h:
+src/x.h:
+src/loop.h:
@@ -0,0 +1,4 @@
+.junk/12term/debug.c.mk .junk/12term/src/debug.c.o: src/debug.c \
+ src/common.h src/debug.h
+src/common.h:
+src/debug.h:
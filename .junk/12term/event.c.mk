@@ -0,0 +1,17 @@
+.junk/12term/event.c.mk .junk/12term/src/event.c.o: src/event.c \
+ src/common.h src/debug.h src/event.h src/x.h src/buffer.h src/keymap.h \
+ src/tty.h src/draw.h src/settings.h src/clipboard.h src/frame.h \
+ src/loop.h src/latency.h
+src/common.h:
+src/debug.h:
+src/event.h:
+src/x.h:
+src/buffer.h:
+src/keymap.h:
+src/tty.h:
+src/draw.h:
+src/settings.h:
+src/clipboard.h:
+src/frame.h:
+src/loop.h:
+src/latency.h:
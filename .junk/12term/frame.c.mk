@@ -0,0 +1,6 @@
+.junk/12term/frame.c.mk .junk/12term/src/frame.c.o: src/frame.c \
+ src/common.h src/debug.h src/frame.h src/loop.h
+src/common.h:
+src/debug.h:
+src/frame.h:
+src/loop.h:
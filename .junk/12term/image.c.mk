@@ -0,0 +1,10 @@
+.junk/12term/image.c.mk .junk/12term/src/image.c.o: src/image.c \
+ src/common.h src/debug.h src/image.h src/settings.h src/buffer.h \
+ src/vt.h src/ctlseqs.h
+src/common.h:
+src/debug.h:
+src/image.h:
+src/settings.h:
+src/buffer.h:
+src/vt.h:
+src/ctlseqs.h:
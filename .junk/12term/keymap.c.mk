@@ -0,0 +1,7 @@
+.junk/12term/keymap.c.mk .junk/12term/src/keymap.c.o: src/keymap.c \
+ src/keymap.h src/common.h src/debug.h src/event.h src/paste.h
+src/keymap.h:
+src/common.h:
+src/debug.h:
+src/event.h:
+src/paste.h:
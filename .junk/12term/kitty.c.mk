@@ -0,0 +1,12 @@
+.junk/12term/kitty.c.mk .junk/12term/src/kitty.c.o: src/kitty.c \
+ src/common.h src/debug.h src/kitty.h src/image.h src/vt.h src/buffer.h \
+ src/ctlseqs.h src/buffer2.h src/base64.h
+src/common.h:
+src/debug.h:
+src/kitty.h:
+src/image.h:
+src/vt.h:
+src/buffer.h:
+src/ctlseqs.h:
+src/buffer2.h:
+src/base64.h:
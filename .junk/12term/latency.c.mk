@@ -0,0 +1,6 @@
+.junk/12term/latency.c.mk .junk/12term/src/latency.c.o: src/latency.c \
+ src/common.h src/debug.h src/latency.h src/loop.h
+src/common.h:
+src/debug.h:
+src/latency.h:
+src/loop.h:
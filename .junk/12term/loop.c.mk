@@ -0,0 +1,5 @@
+.junk/12term/loop.c.mk .junk/12term/src/loop.c.o: src/loop.c src/common.h \
+ src/debug.h src/loop.h
+src/common.h:
+src/debug.h:
+src/loop.h:
@@ -0,0 +1,8 @@
+.junk/12term/paste.c.mk .junk/12term/src/paste.c.o: src/paste.c \
+ src/common.h src/debug.h src/paste.h src/ring.h src/tty.h src/buffer.h
+src/common.h:
+src/debug.h:
+src/paste.h:
+src/ring.h:
+src/tty.h:
+src/buffer.h:
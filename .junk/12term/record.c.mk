@@ -0,0 +1,9 @@
+.junk/12term/record.c.mk .junk/12term/src/record.c.o: src/record.c \
+ src/common.h src/debug.h src/record.h src/settings.h src/buffer.h \
+ src/loop.h
+src/common.h:
+src/debug.h:
+src/record.h:
+src/settings.h:
+src/buffer.h:
+src/loop.h:
@@ -0,0 +1,5 @@
+.junk/12term/ring.c.mk .junk/12term/src/ring.c.o: src/ring.c src/common.h \
+ src/debug.h src/ring.h
+src/common.h:
+src/debug.h:
+src/ring.h:
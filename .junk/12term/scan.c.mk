@@ -0,0 +1,5 @@
+.junk/12term/scan.c.mk .junk/12term/src/scan.c.o: src/scan.c src/common.h \
+ src/debug.h src/scan.h
+src/common.h:
+src/debug.h:
+src/scan.h:
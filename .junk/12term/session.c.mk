@@ -0,0 +1,12 @@
+.junk/12term/session.c.mk .junk/12term/src/session.c.o: src/session.c \
+ src/common.h src/debug.h src/session.h src/buffer.h src/ctlseqs.h \
+ src/tty.h src/loop.h src/vt.h src/daemon.h
+src/common.h:
+src/debug.h:
+src/session.h:
+src/buffer.h:
+src/ctlseqs.h:
+src/tty.h:
+src/loop.h:
+src/vt.h:
+src/daemon.h:
@@ -0,0 +1,7 @@
+.junk/12term/settings.c.mk .junk/12term/src/settings.c.o: src/settings.c \
+ src/buffer.h src/common.h src/debug.h src/settings.h src/x.h
+src/buffer.h:
+src/common.h:
+src/debug.h:
+src/settings.h:
+src/x.h:
@@ -0,0 +1,12 @@
+.junk/12term/sixel.c.mk .junk/12term/src/sixel.c.o: src/sixel.c \
+ src/common.h src/debug.h src/sixel.h src/image.h src/settings.h \
+ src/buffer.h src/vt.h src/ctlseqs.h src/buffer2.h
+src/common.h:
+src/debug.h:
+src/sixel.h:
+src/image.h:
+src/settings.h:
+src/buffer.h:
+src/vt.h:
+src/ctlseqs.h:
+src/buffer2.h:
@@ -0,0 +1,16 @@
+.junk/12term/tty.c.mk .junk/12term/src/tty.c.o: src/tty.c src/common.h \
+ src/debug.h src/tty.h src/ctlseqs.h src/settings.h src/buffer.h \
+ src/ring.h src/loop.h src/record.h src/latency.h src/session.h \
+ src/daemon.h
+src/common.h:
+src/debug.h:
+src/tty.h:
+src/ctlseqs.h:
+src/settings.h:
+src/buffer.h:
+src/ring.h:
+src/loop.h:
+src/record.h:
+src/latency.h:
+src/session.h:
+src/daemon.h:
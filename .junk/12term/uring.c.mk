@@ -0,0 +1,5 @@
+.junk/12term/uring.c.mk .junk/12term/src/uring.c.o: src/uring.c \
+ src/common.h src/debug.h src/uring.h
+src/common.h:
+src/debug.h:
+src/uring.h:
@@ -0,0 +1,8 @@
+.junk/12term/vt.c.mk .junk/12term/src/vt.c.o: src/vt.c src/common.h \
+ src/debug.h src/vt.h src/buffer.h src/ctlseqs.h src/settings.h
+src/common.h:
+src/debug.h:
+src/vt.h:
+src/buffer.h:
+src/ctlseqs.h:
+src/settings.h:
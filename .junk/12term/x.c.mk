@@ -0,0 +1,27 @@
+.junk/12term/x.c.mk .junk/12term/src/x.c.o: src/x.c src/common.h \
+ src/debug.h src/tty.h src/draw.h src/buffer.h src/x.h src/event.h \
+ src/settings.h src/icon.h src/loop.h src/paste.h src/record.h src/vt.h \
+ src/ctlseqs.h src/frame.h src/latency.h src/clipboard.h src/draw2.h \
+ src/image.h src/daemon.h src/session.h src/xft/Xft.h
+src/common.h:
+src/debug.h:
+src/tty.h:
+src/draw.h:
+src/buffer.h:
+src/x.h:
+src/event.h:
+src/settings.h:
+src/icon.h:
+src/loop.h:
+src/paste.h:
+src/record.h:
+src/vt.h:
+src/ctlseqs.h:
+src/frame.h:
+src/latency.h:
+src/clipboard.h:
+src/draw2.h:
+src/image.h:
+src/daemon.h:
+src/session.h:
+src/xft/Xft.h:
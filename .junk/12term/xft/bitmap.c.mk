@@ -0,0 +1,8 @@
+.junk/12term/xft/bitmap.c.mk .junk/12term/src/xft/bitmap.c.o: \
+ src/xft/bitmap.c src/xft/xftint.h src/xft/Xft.h src/xft/../common.h \
+ src/xft/../debug.h src/xft/../x.h
+src/xft/xftint.h:
+src/xft/Xft.h:
+src/xft/../common.h:
+src/xft/../debug.h:
+src/xft/../x.h:
@@ -0,0 +1,10 @@
+.junk/12term/xft/cache.c.mk .junk/12term/src/xft/cache.c.o: \
+ src/xft/cache.c src/xft/../common.h src/xft/../debug.h src/xft/xftint.h \
+ src/xft/Xft.h src/xft/../x.h src/xft/../settings.h src/xft/../buffer.h
+src/xft/../common.h:
+src/xft/../debug.h:
+src/xft/xftint.h:
+src/xft/Xft.h:
+src/xft/../x.h:
+src/xft/../settings.h:
+src/xft/../buffer.h:
@@ -0,0 +1,8 @@
+.junk/12term/xft/glyphs.c.mk .junk/12term/src/xft/glyphs.c.o: \
+ src/xft/glyphs.c src/xft/xftint.h src/xft/Xft.h src/xft/../common.h \
+ src/xft/../debug.h src/xft/../x.h
+src/xft/xftint.h:
+src/xft/Xft.h:
+src/xft/../common.h:
+src/xft/../debug.h:
+src/xft/../x.h:
@@ -0,0 +1,133 @@
+// Base64 decoding
+// used for OSC 52 clipboard data and kitty graphics payloads, which can be several megabytes and arrive in pieces.
+// the decoder keeps its state between calls, and decodes each piece into a buffer supplied by the caller
+// both alphabets are accepted (`+/` and `-_`), padding is optional, and whitespace is skipped. anything else is an error
+// runs of 16 chars are decoded with SSSE3 when possible (https://arxiv.org/abs/1704.00605)
+
+#include <string.h>
+
+#include "common.h"
+#include "base64.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+ #include <immintrin.h>
+ #define BASE64_X86 1
+#endif
+
+enum {
+	INVALID = 0,
+	SPACE = -1,
+	PAD = -2,
+};
+
+// (values are stored +1, so that the chars that aren't listed are INVALID)
+static const int8_t values[256] = {
+	['A'] = 1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,26,
+	['a'] = 27,28,29,30,31,32,33,34,35,36,37,38,39,40,41,42,43,44,45,46,47,48,49,50,51,52,
+	['0'] = 53,54,55,56,57,58,59,60,61,62,
+	['+'] = 63, ['-'] = 63,
+	['/'] = 64, ['_'] = 64,
+	[' '] = SPACE, ['\t'] = SPACE, ['\r'] = SPACE, ['\n'] = SPACE,
+	['='] = PAD,
+};
+
+static size_t decode_scalar(Base64* b, size_t len, const utf8 in[len], uint8_t* out) {
+	uint8_t* start = out;
+	FOR (i, len) {
+		int v = values[(unsigned char)in[i]];
+		if (v > 0) {
+			if (b->padding) {
+				b->error = true;
+				break;
+			}
+			b->buffer = b->buffer<<6 | (v-1);
+			b->bits += 6;
+			if (b->bits >= 8) {
+				b->bits -= 8;
+				*out++ = b->buffer >> b->bits;
+			}
+			b->count = (b->count+1) & 3;
+		} else if (v == PAD) {
+			// (the leftover bits are discarded)
+			if (b->count<2 && !b->padding) {
+				b->error = true;
+				break;
+			}
+			b->padding = true;
+			b->bits = 0;
+			b->count = (b->count+1) & 3;
+			if (b->count == 0)
+				b->padding = false;
+		} else if (v == INVALID) {
+			b->error = true;
+			break;
+		}
+	}
+	return out-start;
+}
+
+#ifdef BASE64_X86
+// decode 16 chars into 12 bytes, if they're all from the `+/` alphabet
+__attribute__((target("ssse3")))
+static size_t decode_ssse3(size_t len, const utf8 in[len], uint8_t* out, size_t* used) {
+	// these find each char's range (from its high and low nibbles), to check that it's valid, and pick the offset that turns it into its value
+	const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+	const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i nibble = _mm_set1_epi8(0x0F);
+	const __m128i slash = _mm_set1_epi8('/');
+	size_t i = 0, n = 0;
+	for (; i+16 <= len; i+=16, n+=12) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(in+i));
+		__m128i hi = _mm_and_si128(_mm_srli_epi32(v, 4), nibble);
+		__m128i lo = _mm_and_si128(v, nibble);
+		__m128i check = _mm_and_si128(_mm_shuffle_epi8(lut_lo, lo), _mm_shuffle_epi8(lut_hi, hi));
+		if (_mm_movemask_epi8(_mm_cmpgt_epi8(check, _mm_setzero_si128())))
+			break; // (something else: let the scalar decoder handle it)
+		__m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(_mm_cmpeq_epi8(v, slash), hi));
+		v = _mm_add_epi8(v, roll);
+		// pack the 6 bit values together: 4 chars -> 24 bits, in each 32 bit lane
+		v = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+		v = _mm_madd_epi16(v, _mm_set1_epi32(0x00011000));
+		v = _mm_shuffle_epi8(v, _mm_setr_epi8(2,1,0, 6,5,4, 10,9,8, 14,13,12, -1,-1,-1,-1));
+		uint8_t temp[16];
+		_mm_storeu_si128((__m128i*)temp, v);
+		memcpy(out+n, temp, 12);
+	}
+	*used = i;
+	return n;
+}
+#endif
+
+// decode `len` chars, and write the bytes to `out`. returns the number of bytes written
+// after an error, the rest of the input is ignored (see base64_end())
+size_t base64_decode(Base64* b, size_t len, const utf8 in[len], uint8_t out[BASE64_DECODED_SIZE(len)]) {
+	size_t i = 0, n = 0;
+#ifdef BASE64_X86
+	static int ssse3 = -1;
+	if (ssse3 < 0)
+		ssse3 = __builtin_cpu_supports("ssse3");
+#endif
+	while (i<len && !b->error) {
+#ifdef BASE64_X86
+		// (only at the start of a group)
+		if (ssse3 && b->count==0 && !b->padding && len-i >= 16) {
+			size_t used;
+			n += decode_ssse3(len-i, in+i, out+n, &used);
+			i += used;
+		}
+#endif
+		// decode at least one group normally, to get past whatever stopped the fast path
+		size_t chunk = len-i < 16 ? len-i : 16;
+		n += decode_scalar(b, chunk, in+i, out+n);
+		i += chunk;
+	}
+	return n;
+}
+
+// call this after the last piece. returns false if the input was invalid or cut off
+bool base64_end(Base64* b) {
+	bool ok = !b->error && !b->padding && b->count!=1;
+	*b = (Base64){0};
+	return ok;
+}
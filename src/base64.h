@@ -0,0 +1,19 @@
+#pragma once
+// Base64 decoding (see base64.c)
+
+#include "common.h"
+
+// decoder state, so the input can be split anywhere
+typedef struct Base64 {
+	uint32_t buffer; // bits that haven't been output yet
+	int bits;
+	int count; // chars in the current group of 4
+	bool padding; // inside the `=` padding at the end of a group
+	bool error;
+} Base64;
+
+// max number of bytes that decoding `len` chars can output
+#define BASE64_DECODED_SIZE(len) ((len)/4*3+3)
+
+size_t base64_decode(Base64* state, size_t len, const utf8 in[len], uint8_t out[BASE64_DECODED_SIZE(len)]);
+bool base64_end(Base64* state);
@@ -0,0 +1,121 @@
+// Headless benchmark
+// replays a recording (see record.h) or a raw stream of pty output through the parser and buffer, with no X connection, and reports how fast it went.
+// build with `make 12term-bench`, then: `./12term-bench [-n repeat] [-s WIDTHxHEIGHT] file`
+
+#define _POSIX_C_SOURCE 200112L
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "common.h"
+#include "buffer.h"
+#include "ctlseqs.h"
+#include "ctlseqs2.h"
+#include "settings.h"
+#include "vt.h"
+#include "record.h"
+
+static Nanosec now(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (Nanosec)t.tv_sec*1000*1000*1000 + t.tv_nsec;
+}
+
+static size_t total_bytes = 0;
+static size_t total_lines = 0;
+
+static void feed(size_t len, const utf8* data) {
+	total_bytes += len;
+	for (const utf8* p = data; (p = memchr(p, '\n', data+len-p)); p++)
+		total_lines++;
+	process_chars(len, data);
+}
+
+// feed the file through the parser once
+static void replay(size_t size, const utf8* data) {
+	size_t magic = sizeof(RECORD_MAGIC)-1;
+	if (size < magic || memcmp(data, RECORD_MAGIC, magic)) {
+		// not a recording: just feed it in (in pty-sized chunks)
+		for (size_t i=0; i<size; i+=4096)
+			feed(size-i < 4096 ? size-i : 4096, data+i);
+		return;
+	}
+	for (size_t i=magic; i+sizeof(RecordHeader) <= size; ) {
+		RecordHeader head;
+		memcpy(&head, data+i, sizeof(head));
+		i += sizeof(head);
+		if (head.length > size-i) {
+			print("recording is truncated\n");
+			break;
+		}
+		if (head.type==REC_OUTPUT)
+			feed(head.length, data+i);
+		else if (head.type==REC_RESIZE) {
+			RecordResize r;
+			memcpy(&r, data+i, sizeof(r));
+			term_resize(r.width, r.height);
+		}
+		i += head.length;
+	}
+}
+
+int main(int argc, char** argv) {
+	int repeat = 1;
+	int width = settings.width, height = settings.height;
+	int opt;
+	while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+		if (opt=='n')
+			repeat = atoi(optarg);
+		else if (opt=='s')
+			sscanf(optarg, "%dx%d", &width, &height);
+		else
+			return 1;
+	}
+	if (optind >= argc) {
+		fprintf(stderr, "usage: %s [-n repeat] [-s WIDTHxHEIGHT] file\n", argv[0]);
+		return 1;
+	}
+	// the parser complains about every unknown sequence, and we don't want to time that
+	debug_enabled = false;
+	
+	Fd fd = open(argv[optind], O_RDONLY);
+	struct stat st;
+	if (fd<0 || fstat(fd, &st)<0)
+		die("couldn't open '%s': %s\n", argv[optind], strerror(errno));
+	utf8* data = NULL;
+	if (st.st_size) {
+		data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data==MAP_FAILED)
+			die("mmap failed: %s\n", strerror(errno));
+	}
+	
+	// (no callbacks are set, so responses, title changes, etc. are just ignored)
+	vt_init(width, height);
+	
+	Nanosec start = now();
+	FOR (i, repeat)
+		replay(st.st_size, data);
+	double secs = (now()-start)/1e9;
+	
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	
+	printf("%zu bytes, %zu lines in %.3f s\n", total_bytes, total_lines, secs);
+	printf("%.1f MB/s, %.0f lines/s\n", total_bytes/secs/1e6, total_lines/secs);
+	printf("peak RSS: %ld KB\n", usage.ru_maxrss);
+#ifdef PARSE_STATS
+	printf("\n%-20s %12s %10s %8s\n", "state", "bytes", "ms", "ns/byte");
+	FOR (i, PARSE_STATES) {
+		ParseStats s = parse_stats[i];
+		if (s.bytes)
+			printf("%-20s %12llu %10.1f %8.1f\n", parse_state_name(i), (unsigned long long)s.bytes, s.time/1e6, (double)s.time/s.bytes);
+	}
+#endif
+	return 0;
+}
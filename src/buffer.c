@@ -2,18 +2,20 @@
 
 #define _XOPEN_SOURCE 600
 #include <wchar.h>
+#include <stddef.h>
 #include <string.h>
 #include <unistd.h>
 
 #include "common.h"
 #include "buffer.h"
 #include "ctlseqs.h"
+#include "image.h"
 #include "settings.h"
-#include "draw2.h"
+#include "vt.h"
 
-Term T;
+PER_WINDOW Term T;
 
-static struct history {
+PER_WINDOW static struct history {
 	Row** rows; // array of pointers
 	int size; // length of ring buffer
 		
@@ -34,11 +36,13 @@ static void free_history(void) {
 	if (history.rows) {
 		for (int i=1; i<=history.length; i++)
 			FREE(history.rows[(history.head-i+history.size) % history.size]);
+		FREE(history.rows);
 	}
 }
 
 // clear + init
 void init_history(void) {
+	placements_clear(0, -history.size, 0);
 	free_history();
 	
 	history.size = settings.saveLines;
@@ -65,13 +69,30 @@ static void clear_row(Row* row, int start, bool bce) {
 	row->cont = false;
 }
 
+// extra space in each buffer's row list, so the list only needs to be moved back once every SCROLL_SLACK lines when scrolling
+#define SCROLL_SLACK 256
+
+// change the length of a buffer's row list, keeping the first `keep` rows
+static void resize_row_list(Buffer* b, int keep, int height) {
+	if (b->rows != b->row_list)
+		memmove(b->row_list, b->rows, sizeof(Row*)*keep);
+	REALLOC(b->row_list, height+SCROLL_SLACK);
+	b->rows = b->row_list;
+}
+
 void term_free(void) {
 	FOR (scr, 2) {
 		FOR (y, T.height) {
 			free(T.buffers[scr].rows[y]);
 		}
+		FREE(T.buffers[scr].row_list);
+		T.buffers[scr].rows = NULL;
 	}
 	free(T.tabs);
+	FOR (i, T.links.length)
+		free(T.links.items[i]);
+	FREE(T.links.items);
+	T.links.length = T.links.size = 0;
 	free_history();
 }
 
@@ -99,24 +120,26 @@ static Row* pop_history(void) {
 }
 
 // idea: scroll lock support
-static void push_history(int y) {
-	if (y<0 || y>=T.height)
-		return;
-	// free oldest item if necessary
+// return: the oldest row, if it was pushed out of the history (or `row` itself, if the history has size 0), otherwise NULL
+// the returned row is owned by the caller (it can be reused instead of allocating a new one)
+static Row* push_history(Row* row) {
+	if (history.size<=0)
+		return row;
+	Row* old = NULL;
+	// remove oldest item if necessary
 	if (history.length == history.size) {
-		FREE(history.rows[history.head]);
+		old = history.rows[history.head];
 	} else {
 		history.length++;
 	}
 	// move row into history
-	Row* new = T.buffers[0].rows[y];
-	history.rows[history.head] = new;
-	T.buffers[0].rows[y] = NULL; // set to null so it doesn't get freed
+	history.rows[history.head] = row;
 	// move head forward to next slot
 	incwrap(&history.head, history.size);
 	// adjust scroll offset if we are scrolled up currently
-	if (T.scroll>0)
+	if (T.scroll>0 && T.scroll<history.length)
 		T.scroll++;
+	return old;
 }
 
 // change the number of cells in a Row
@@ -165,11 +188,13 @@ void term_resize(int width, int height) {
 	int diff = height-T.height;
 	//// height decrease ////
 	if (height < T.height) { // diff < 0
+		placements_shift(0, -history.size, T.height, diff, -history.size);
+		placements_shift(1, 0, T.height, diff, 0);
 		// upper rows
 		int y = 0;
 		for (; y < -diff; y++) {
 			// main buffer: put lines into history
-			push_history(y);
+			free(push_history(T.buffers[0].rows[y]));
 			// alt buffer: free
 			free(T.buffers[1].rows[y]);
 		}
@@ -179,7 +204,7 @@ void term_resize(int width, int height) {
 				T.buffers[scr].rows[y+diff] = T.buffers[scr].rows[y];
 		// realloc lists of lines
 		FOR (scr, 2)
-			REALLOC(T.buffers[scr].rows, height);
+			resize_row_list(&T.buffers[scr], height, height);
 		T.height = height;
 		// adjust cursor position
 		T.c.y = limit(T.c.y+diff, 0, T.height-1);
@@ -189,8 +214,10 @@ void term_resize(int width, int height) {
 	} else if (height > T.height) { // height INCREASE (diff > 0)
 		// realloc lists of lines
 		FOR (scr, 2)
-			REALLOC(T.buffers[scr].rows, height);
+			resize_row_list(&T.buffers[scr], T.height, height);
 		T.height = height;
+		placements_shift(0, -history.size, T.height, diff, -history.size);
+		placements_shift(1, 0, T.height, diff, 0);
 		// iterate from bottom to top
 		int y = T.height-1;
 		// lower rows: shift downwards
@@ -310,17 +337,26 @@ void full_reset(void) {
 	T.app_cursor = false;
 	T.mouse_mode = 0;
 	T.mouse_encoding = 0;
+	T.synchronized = false;
 	
 	FOR (i, T.links.length)
 		free(T.links.items[i]);
 	T.links.length = 0;
 	
+	image_delete_all();
+	
 	reset_parser();
 }
 
 // todo: um we need to free these??
 int new_link(utf8* url) {
-	if (T.links.length < LEN(T.links.items))
+	if (T.links.length == T.links.size && T.links.size < MAX_LINKS) {
+		T.links.size = T.links.size ? T.links.size*2 : 16;
+		if (T.links.size > MAX_LINKS)
+			T.links.size = MAX_LINKS;
+		REALLOC(T.links.items, T.links.size);
+	}
+	if (T.links.length < T.links.size)
 		if ((T.links.items[T.links.length] = strdup(url)))
 			return T.links.length++;
 	print("failed to allocate hyperlink\n");
@@ -373,7 +409,8 @@ static void rotate(int count, int itemsize, uint8_t data[count][itemsize], int a
 // and clear the "new" lines
 static void shift_rows(int y1, int y2, int amount, bool bce) {
 	ROTATE(&T.current->rows[y1], y2-y1, amount);
-	draw_rotate_rows(y1, y2, amount, false);
+	vt_rotate_rows(y1, y2, amount, false);
+	placements_shift(T.current==&T.buffers[1], y1, y2, amount, y1);
 	if (amount>0) { // down
 		for (int y=y1; y<y1+amount; y++)
 			clear_row(T.current->rows[y], 0, bce);
@@ -392,18 +429,63 @@ static void scroll_down_internal(int amount) {
 	shift_rows(y1, y2, amount, true);
 }
 
+// scroll the entire screen up
+// instead of rotating the row list, this moves `rows` forward and puts the new rows after the end (see SCROLL_SLACK)
+static void scroll_screen(int amount, bool bce, bool history_push) {
+	Buffer* b = T.current;
+	vt_rotate_rows(0, T.height, -(amount<T.height ? amount : T.height), false);
+	if (history_push)
+		placements_shift(0, -history.size, T.height, -amount, -history.size);
+	else
+		placements_shift(1, 0, T.height, -amount, 0);
+	FOR (i, amount) {
+		// take the top row (and put it into the history), and reuse it or the row that fell out of the history
+		Row* row = b->rows[0];
+		if (history_push) {
+			row = push_history(row);
+			if (!row)
+				row = malloc(sizeof(Row) + sizeof(Cell)*T.width);
+		}
+		clear_row(row, 0, bce);
+		if (b->rows-b->row_list >= SCROLL_SLACK) {
+			memmove(b->row_list, b->rows, sizeof(Row*)*T.height);
+			b->rows = b->row_list;
+		}
+		b->rows++;
+		b->rows[T.height-1] = row;
+	}
+}
+
+// scrolling by more than the region's height is the same as scrolling one line at a time: the extra blank lines go into the history too.
+// (so runs of newlines can be applied all at once, see process_chars())
 static void scroll_up_internal(int amount, bool bce) {
 	int y1 = T.scroll_top;
 	int y2 = T.scroll_bottom;
-	amount = limit(amount, 0, y2-y1);
-	if (y1==0 && T.current==&T.buffers[0])
-		for (int y=y1; y<y1+amount; y++) {
-		// if we are on the main screen, and the scroll region starts at the top of the screen, we add the lines to the history list.
-			push_history(y);
-			// wait but don't we need to clear this?  memory?
-			T.current->rows[y] = malloc(sizeof(Row) + sizeof(Cell)*T.width);
+	// if we are on the main screen, and the scroll region starts at the top of the screen, we add the lines to the history list.
+	bool history_push = y1==0 && T.current==&T.buffers[0];
+	// (anything more than this would just be pushed out of the history again)
+	int max = history_push ? y2-y1+history.size : y2-y1;
+	amount = limit(amount, 0, max);
+	if (amount<=0)
+		return;
+	if (y1==0 && y2==T.height) {
+		scroll_screen(amount, bce, history_push);
+		return;
+	}
+	while (amount > 0) {
+		int n = amount<y2-y1 ? amount : y2-y1;
+		if (history_push) {
+			// (images in these rows, and the scrollback, move up too)
+			placements_shift(0, -history.size, y1+n, -n, -history.size);
+			for (int y=y1; y<y1+n; y++) {
+				Row* old = push_history(T.current->rows[y]);
+				// (shift_rows() clears this)
+				T.current->rows[y] = old ? old : malloc(sizeof(Row) + sizeof(Cell)*T.width);
+			}
 		}
-	shift_rows(y1, y2, -amount, bce);
+		shift_rows(y1, y2, -n, bce);
+		amount -= n;
+	}
 }
 
 void cursor_to(int x, int y) {
@@ -416,7 +498,8 @@ void cursor_to(int x, int y) {
 // these scroll + move the cursor with the scrolled text
 // todo: confirm the cases where these are supposed to move the cursor
 void scroll_up(int amount) {
-	scroll_up_internal(amount, true);
+	// (unlike with newlines, scrolling past the height of the region doesn't push extra blank lines into the history)
+	scroll_up_internal(limit(amount, 0, T.scroll_bottom-T.scroll_top), true);
 	if (T.c.y>=T.scroll_top && T.c.y<T.scroll_bottom) {
 		amount = limit(amount, 0, T.c.y-T.scroll_top);
 		cursor_to(T.c.x, T.c.y-amount);
@@ -601,61 +684,118 @@ static bool add_combining_char(Char c) {
 	return false;
 }
 
-void put_char(Char c) {
-	// note: ref xterm/util.c/WriteText, xterm/screen.c/ScrnWriteText
-	if (T.charsets[0] == '0') {
-		if (c<128 && c>=0 && DEC_GRAPHICS_CHARSET[c])
-			c = DEC_GRAPHICS_CHARSET[c];
-	}
-	
-	int width = char_width(c);
-	
-	if (width==0) {
-		add_combining_char(c);
-		return;
-	}
-	
-	// wrap
-	if (T.c.x+width > T.width) {
-		T.current->rows[T.c.y]->wrap = true;
-		forward_index(1);
-		T.c.x = 0;
-		T.current->rows[T.c.y]->cont = true;
-	}
-	
-	Cell* dest = &T.current->rows[T.c.y]->cells[T.c.x];
-	// technically we'll only ever have to do one of these, but it's easier to check both rather than keeping track... (though, we could save on bounds checks too...)
-	clean_wc_left(dest, T.c.x);
-	clean_wc_right(&dest[width], T.c.x+width);
-	
-	*dest = (Cell){
-		.chr = c,
-		.wide = width==2,
-		.attrs = T.c.attrs,
-	};
+// the cell that text is written with: the cursor's attributes, with reverse and bold applied
+static Cell text_cell(void) {
+	Cell cell = {.attrs = T.c.attrs};
 	if (T.c.attrs.reverse) {
-		dest->attrs.color = T.c.attrs.background;
-		dest->attrs.background = T.c.attrs.color;
+		cell.attrs.color = T.c.attrs.background;
+		cell.attrs.background = T.c.attrs.color;
 	}
 	if (T.c.attrs.weight==1) { // mm we do this after reverse right?
-		if (!dest->attrs.color.truecolor) {
-			int i = dest->attrs.color.i;
+		if (!cell.attrs.color.truecolor) {
+			int i = cell.attrs.color.i;
 			if (i>=0 && i<8)
-				dest->attrs.color.i += 8;
+				cell.attrs.color.i += 8;
 		}
 	}
+	return cell;
+}
+
+// write a run of characters at the cursor
+// same as calling put_char() for each one, but the attributes are only worked out once, and wide chars that get partially overwritten only need to be fixed at the ends of each row segment
+void put_chars(int len, const Char cs[len]) {
+	// note: ref xterm/util.c/WriteText, xterm/screen.c/ScrnWriteText
+	Cell cell = text_cell();
+	bool dec_graphics = T.charsets[0] == '0';
+	Row* row = T.current->rows[T.c.y];
+	int start = T.c.x; // start of the current row segment
+	FOR (i, len) {
+		Char c = cs[i];
+		if (dec_graphics) {
+			if (c<128 && c>=0 && DEC_GRAPHICS_CHARSET[c])
+				c = DEC_GRAPHICS_CHARSET[c];
+		}
+		
+		int width = char_width(c);
+		
+		if (width==0) {
+			add_combining_char(c);
+			continue;
+		}
+		
+		// wrap
+		if (T.c.x+width > T.width) {
+			if (T.c.x > start)
+				clean_wc_right(&row->cells[T.c.x], T.c.x);
+			row->wrap = true;
+			forward_index(1);
+			T.c.x = 0;
+			row = T.current->rows[T.c.y];
+			row->cont = true;
+			start = 0;
+		}
+		
+		Cell* dest = &row->cells[T.c.x];
+		if (T.c.x == start)
+			clean_wc_left(dest, T.c.x);
+		*dest = cell;
+		dest->chr = c;
+		dest->wide = width==2;
+		if (width==2)
+			add_dummy(dest);
+		
+		// todo: figure out if there are any other places where we need to reset/adjust these
+		T.last = true;
+		T.last_x = T.c.x;
+		T.last_y = T.c.y;
+		
+		T.c.x += width;
+	}
+	if (T.c.x > start)
+		clean_wc_right(&row->cells[T.c.x], T.c.x);
+}
+
+void put_char(Char c) {
+	put_chars(1, &c);
+}
+
+// same as put_chars(), but only for printable ascii (0x20-0x7E), straight from the input
+// (these are all single width, so a whole row segment can be filled at once)
+void put_ascii(int len, const utf8 s[len]) {
+	if (len<=0)
+		return;
+	if (T.charsets[0] == '0') {
+		FOR (i, len)
+			put_char(s[i]);
+		return;
+	}
 	
-	if (width==2)
-		add_dummy(dest);
-	
-	// todo: figure out if there are any other places where we need to reset/adjust these
+	Cell cell = text_cell();
+	while (len > 0) {
+		// wrap
+		if (T.c.x+1 > T.width) {
+			T.current->rows[T.c.y]->wrap = true;
+			forward_index(1);
+			T.c.x = 0;
+			T.current->rows[T.c.y]->cont = true;
+		}
+		int n = T.width-T.c.x;
+		if (n > len)
+			n = len;
+		Cell* dest = &T.current->rows[T.c.y]->cells[T.c.x];
+		clean_wc_left(dest, T.c.x);
+		clean_wc_right(&dest[n], T.c.x+n);
+		FOR (i, n) {
+			cell.chr = s[i];
+			dest[i] = cell;
+		}
+		T.last_x = T.c.x+n-1;
+		T.last_y = T.c.y;
+		T.c.x += n;
+		s += n;
+		len -= n;
+	}
 	T.last = true;
-	T.last_x = T.c.x;
-	T.last_y = T.c.y;
-	
-	T.c.x += width;
-	//	if (T.current->rows[T.c.y]->length<T.c.x)
-	//		T.current->rows[T.c.y]->length = T.c.x;
 }
 
 void backspace(void) {
@@ -768,8 +908,10 @@ void switch_buffer(bool alt) {
 	bool prev = T.current==&T.buffers[1];
 	if (prev != alt) {
 		T.current = &T.buffers[alt];
-		if (alt)
+		if (alt) {
 			clear_region(0, 0, T.width, T.height);
+			placements_clear(1, 0, T.height);
+		}
 	}
 }
 
@@ -805,7 +947,7 @@ void set_scrollback(int pos) {
 	//print("scrolling %d\n", pos);
 	int dist = pos-T.scroll;
 	if (abs(dist)<T.height)
-		draw_rotate_rows(0, T.height, dist, true);
+		vt_rotate_rows(0, T.height, dist, true);
 	T.scroll = pos;
 }
 
@@ -823,3 +965,138 @@ Row* get_row(int y) {
 		return history.rows[(history.head+y+history.size) % history.size];
 	return NULL;
 }
+
+// == snapshots ==
+// the whole terminal state (screen, history, modes, etc.) in a compact form, which can be loaded by another 12term process (see session.c)
+// rows are saved without their trailing blank cells, so mostly-empty history lines don't take up much space.
+
+typedef struct SnapshotRow {
+	uint32_t length; // number of cells saved
+	bool wrap, cont;
+} SnapshotRow;
+
+// whether a cell looks the same as an empty one
+static bool blank_cell(const Cell* c) {
+	return !c->chr && !c->wide && !c->attrs.background.truecolor && c->attrs.background.i==-2 && !c->attrs.underline && !c->attrs.reverse && !c->attrs.strikethrough && !c->attrs.link;
+}
+
+static void save_row(void (*write)(size_t len, const void* data), const Row* row) {
+	int len = T.width;
+	while (len>0 && blank_cell(&row->cells[len-1]))
+		len--;
+	write(sizeof(SnapshotRow), &(SnapshotRow){.length = len, .wrap = row->wrap, .cont = row->cont});
+	write(sizeof(Cell)*len, row->cells);
+}
+
+static Row* load_row(bool (*read)(size_t len, void* data)) {
+	SnapshotRow h;
+	if (!read(sizeof(h), &h) || h.length > T.width)
+		return NULL;
+	Row* row = malloc(sizeof(Row) + sizeof(Cell)*T.width);
+	if (!read(sizeof(Cell)*h.length, row->cells)) {
+		free(row);
+		return NULL;
+	}
+	for (int x=h.length; x<T.width; x++)
+		row->cells[x] = (Cell){.attrs = {.color = {.i=-1}, .background = {.i=-2}}};
+	row->wrap = h.wrap;
+	row->cont = h.cont;
+	return row;
+}
+
+// the fields of T which are saved directly (everything except the links, which are saved separately)
+#define LINKS_START offsetof(Term, links)
+#define LINKS_END (offsetof(Term, links) + sizeof(T.links))
+
+void term_save(void (*write)(size_t len, const void* data)) {
+	// (the pointers in here are replaced when loading)
+	write(LINKS_START, &T);
+	write(sizeof(Term)-LINKS_END, (uint8_t*)&T + LINKS_END);
+	int current = T.current - T.buffers;
+	write(sizeof(current), &current);
+	write(sizeof(bool)*(T.width+1), T.tabs);
+	FOR (scr, 2)
+		FOR (y, T.height)
+			save_row(write, T.buffers[scr].rows[y]);
+	// history, oldest first
+	write(sizeof(history.length), &history.length);
+	for (int i=history.length; i>=1; i--)
+		save_row(write, history.rows[(history.head-i+history.size) % history.size]);
+	write(sizeof(T.links.length), &T.links.length);
+	FOR (i, T.links.length) {
+		uint32_t len = strlen(T.links.items[i]);
+		write(sizeof(len), &len);
+		write(len, T.links.items[i]);
+	}
+}
+
+// replace the current state with a snapshot from term_save()
+// returns false if the data was invalid (the state is left incomplete, so don't keep using it)
+bool term_load(bool (*read)(size_t len, void* data)) {
+	FOR (scr, 2) {
+		FOR (y, T.height)
+			free(T.buffers[scr].rows[y]);
+		FREE(T.buffers[scr].row_list);
+		T.buffers[scr].rows = NULL;
+	}
+	FREE(T.tabs);
+	FOR (i, T.links.length)
+		free(T.links.items[i]);
+	
+	if (!read(LINKS_START, &T) || !read(sizeof(Term)-LINKS_END, (uint8_t*)&T + LINKS_END))
+		return false;
+	T.links.length = 0;
+	T.scroll = 0;
+	int current;
+	if (!read(sizeof(current), &current) || T.width<=0 || T.height<=0)
+		return false;
+	T.current = &T.buffers[current ? 1 : 0];
+	ALLOC(T.tabs, T.width+1);
+	if (!read(sizeof(bool)*(T.width+1), T.tabs))
+		return false;
+	FOR (scr, 2) {
+		T.buffers[scr].rows = T.buffers[scr].row_list = NULL; // (these were overwritten by the snapshot)
+		resize_row_list(&T.buffers[scr], 0, T.height);
+		FOR (y, T.height)
+			if (!(T.buffers[scr].rows[y] = load_row(read)))
+				return false;
+	}
+	
+	init_history();
+	int length;
+	if (!read(sizeof(length), &length))
+		return false;
+	FOR (i, length) {
+		Row* row = load_row(read);
+		if (!row)
+			return false;
+		// if our history is smaller, drop the oldest lines
+		if (length-i > history.size) {
+			free(row);
+			continue;
+		}
+		history.rows[history.head] = row;
+		incwrap(&history.head, history.size);
+		history.length++;
+	}
+	
+	int links;
+	if (!read(sizeof(links), &links))
+		return false;
+	FOR (i, links) {
+		uint32_t len;
+		if (!read(sizeof(len), &len) || len > 1<<20)
+			return false;
+		utf8* url;
+		ALLOC(url, len+1);
+		bool ok = read(len, url);
+		url[len] = '\0';
+		if (ok)
+			new_link(url);
+		free(url);
+		if (!ok)
+			return false;
+	}
+	vt_dirty_all();
+	return true;
+}
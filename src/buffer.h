@@ -72,6 +72,9 @@ typedef struct Row {
 	Cell cells[]; // allocated after struct
 } Row;
 
+// most hyperlinks one terminal can have (see Attrs.link)
+#define MAX_LINKS 32767
+
 // the cursor keeps track of a position as well as the attributes
 #define Cursor Cursor_
 typedef struct Cursor {
@@ -82,7 +85,8 @@ typedef struct Cursor {
 
 // the main or alternate buffer.
 typedef struct Buffer {
-	Row** rows;
+	Row** rows; // T.height items. this points somewhere inside `row_list`, so scrolling the whole screen can just move it forward (see scroll_screen())
+	Row** row_list; // allocated with SCROLL_SLACK extra items at the end
 	Cursor saved_cursor; // it seems that each buffer has a separate *saved* cursor (while the *current* cursor position itself is shared)
 } Buffer;
 
@@ -124,8 +128,8 @@ typedef struct Term {
 	int charsets[4];
 	
 	struct links {
-		int length;
-		utf8* items[32767];
+		int length, size;
+		utf8** items; // (grows as needed, up to MAX_LINKS)
 	} links;
 	
 	bool app_keypad, app_cursor;
@@ -133,14 +137,20 @@ typedef struct Term {
 	int mouse_mode;
 	int mouse_encoding;
 	bool report_focus; //todo
+	bool synchronized; // inside a synchronized update (mode 2026): the frontend should hold off on drawing until this is cleared
+	
+	int cell_width, cell_height; // size of a cell in pixels (set by the frontend, 0 = unknown). used to size images
 } Term;
 
 void init_term(int width, int height);
+void term_free(void);
 void term_resize(int width, int height);
 void set_scrollback(int pos);
 bool move_scrollback(int amount);
 void dirty_all(void);
 Row* get_row(int y);
 Row* resize_row(Row** row, int size, int old_size);
+void term_save(void (*write)(size_t len, const void* data));
+bool term_load(bool (*read)(size_t len, void* data));
 
 extern Term T;
@@ -22,6 +22,8 @@ void forward_tab(int n);
 
 // inserting/deleting
 void put_char(Char c);
+void put_chars(int len, const Char cs[len]);
+void put_ascii(int len, const utf8 s[len]);
 void delete_chars(int n);
 void insert_blank(int n);
 void delete_lines(int n);
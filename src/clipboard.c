@@ -7,9 +7,10 @@
 #include "clipboard.h"
 #include "tty.h"
 #include "buffer.h"
+#include "paste.h"
 
 // todo: multiple selection types
-static utf8* clipboard_data = NULL;
+PER_WINDOW static utf8* clipboard_data = NULL;
 
 void own_clipboard(utf8* which, utf8* data) {
 	FREE(clipboard_data);
@@ -20,6 +21,10 @@ void own_clipboard(utf8* which, utf8* data) {
 	}
 }
 
+void clipboard_free(void) {
+	FREE(clipboard_data);
+}
+
 void request_clipboard(Atom which) {
 	XConvertSelection(W.d, which, W.atoms.utf8_string, which, W.win, CurrentTime);
 }
@@ -28,83 +33,117 @@ static void update_events(void) {
 	XChangeWindowAttributes(W.d, W.win, CWEventMask, &(XSetWindowAttributes){.event_mask = W.event_mask});
 }
 
-static void tty_paste_text(int len, const char text[len]) {
-	if (T.bracketed_paste)
-		tty_write(6, "\x1B[200~");
-	tty_write(len, text);
-	if (T.bracketed_paste)
-		tty_write(6, "\x1B[201~");
+// state of the selection transfer that's currently feeding the paste queue
+PER_WINDOW static struct transfer {
+	Atom property;
+	bool incr; // data is being sent in chunks (INCR)
+	bool ready; // the property has data we haven't read yet
+	long offset; // read position in the property (in 32-bit units)
+} transfer;
+
+// largest chunk to read from the property at once
+#define FETCH_MAX (64<<10)
+
+// paste source: read the next piece of the selection, if there's one available
+// the property is only deleted after we've read all of it. during an INCR transfer, that's what tells the selection owner to send the next chunk,
+// so the other application only sends data as fast as the paste queue is emptied
+static void fetch_selection(size_t room) {
+	if (!transfer.ready)
+		return;
+	if (room > FETCH_MAX)
+		room = FETCH_MAX;
+	if (room < 4)
+		return;
+	
+	unsigned long nitems, rem;
+	int format;
+	utf8* data;
+	Atom type;
+	if (XGetWindowProperty(W.d, W.win, transfer.property, transfer.offset, room/4, False, AnyPropertyType, &type, &format, &nitems, &rem, (void*)&data)) {
+		print("Clipboard allocation failed\n");
+		transfer.ready = false;
+		paste_end();
+		return;
+	}
+	
+	if (type==W.atoms.incr) {
+		// Activate the PropertyNotify events so we receive
+		// when the selection owner does send us the next
+		// chunk of data.
+		W.event_mask |= PropertyChangeMask;
+		update_events();
+		transfer.incr = true;
+		transfer.ready = false;
+		// Deleting the property is the transfer start signal.
+		XDeleteProperty(W.d, W.win, transfer.property);
+		XFree(data);
+		return;
+	}
+	
+	size_t size = nitems*format/8;
+	if (transfer.incr && transfer.offset==0 && size==0) {
+		// If there is some PropertyNotify with no data, then
+		// this is the signal of the selection owner that all
+		// data has been transferred. We won't need to receive
+		// PropertyNotify events anymore.
+		W.event_mask &= ~PropertyChangeMask;
+		update_events();
+		transfer.ready = false;
+		XDeleteProperty(W.d, W.win, transfer.property);
+		XFree(data);
+		paste_end();
+		return;
+	}
+	
+	paste_push(size, data);
+	XFree(data);
+	// number of 32-bit chunks returned
+	transfer.offset += nitems*format/32;
+	
+	if (rem==0) {
+		transfer.ready = false;
+		transfer.offset = 0;
+		// Deleting the property again tells the selection owner to send the
+		// next data chunk in the property.
+		XDeleteProperty(W.d, W.win, transfer.property);
+		if (!transfer.incr)
+			paste_end();
+	}
+}
+
+// paste cancelled: abandon the transfer
+// (the selection owner might have stalled or exited, so we can't wait for it to finish)
+static void stop_selection(void) {
+	if (transfer.incr) {
+		W.event_mask &= ~PropertyChangeMask;
+		update_events();
+	}
+	XDeleteProperty(W.d, W.win, transfer.property);
+	transfer = (struct transfer){0};
 }
 
 // recieve selection data from another application
 void on_selectionnotify(XEvent* e) {
-	Atom property = None;
-	if (e->type==SelectionNotify)
-		property = e->xselection.property;
-	else if (e->type==PropertyNotify)
-		property = e->xproperty.atom;
-	
+	Atom property = e->xselection.property;
 	if (property==None)
 		return;
 	
-	unsigned long ofs = 0;
-	unsigned long rem;
-	do {
-		unsigned long nitems;
-		int format;
-		utf8* data;
-		Atom type;
-		if (XGetWindowProperty(W.d, W.win, property, ofs, BUFSIZ/4, False, AnyPropertyType, &type, &format, &nitems, &rem, (void*)&data)) {
-			print("Clipboard allocation failed\n");
-			return;
-		}
-		
-		if (e->type==PropertyNotify && nitems==0 && rem==0) {
-			// If there is some PropertyNotify with no data, then
-			// this is the signal of the selection owner that all
-			// data has been transferred. We won't need to receive
-			// PropertyNotify events anymore.
-			W.event_mask &= ~PropertyChangeMask;
-			update_events();
-		}
-		
-		if (type==W.atoms.incr) {
-			// Activate the PropertyNotify events so we receive
-			// when the selection owner does send us the next
-			// chunk of data.
-			W.event_mask |= PropertyChangeMask;
-			update_events();
-			
-			// Deleting the property is the transfer start signal.
-			XDeleteProperty(W.d, W.win, property);
-			continue;
-		}
-		
-		// replace \n with \r
-		utf8* repl = data;
-		utf8* last = data + nitems*format/8;
-		while ((repl = memchr(repl, '\n', last-repl))) {
-			*repl++ = '\r';
-		}
-		
-		// todo: ok so we maybe don't want to route this directly to tty_paste_text
-		tty_paste_text(nitems*format/8, data);
-		
-		XFree(data);
-		// number of 32-bit chunks returned
-		ofs += nitems*format/32;
-	} while (rem>0);
-	// Deleting the property again tells the selection owner to send the
-	// next data chunk in the property.
-	XDeleteProperty(W.d, W.win, property);
+	if (!paste_begin(fetch_selection, stop_selection)) {
+		XDeleteProperty(W.d, W.win, property);
+		return;
+	}
+	transfer = (struct transfer){
+		.property = property,
+		.ready = true,
+	};
 }
 
 void on_propertynotify(XEvent* e) {
 	XPropertyEvent* xpev = &e->xproperty;
-	if (e->xproperty.state==PropertyNewValue) {
-		Atom type = xpev->atom;
-		if (type==XA_PRIMARY || type==W.atoms.clipboard)
-			on_selectionnotify(e);
+	// next chunk of an INCR transfer
+	if (xpev->state==PropertyNewValue && transfer.incr && xpev->atom==transfer.property) {
+		transfer.ready = true;
+		transfer.offset = 0;
 	}
 }
 
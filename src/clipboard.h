@@ -8,3 +8,4 @@ void on_selectionrequest(XEvent* e);
 
 void own_clipboard(utf8* which, utf8* string);
 void request_clipboard(Atom which);
+void clipboard_free(void);
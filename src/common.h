@@ -13,6 +13,10 @@
 // you should use { } around the body otherwise the highlighter/indenter complains
 #define FOR(var, end) for (int var=0; var<end; var++)
 
+// put this on global variables that belong to one terminal window (the screen, parser, pty, etc.)
+// in daemon mode, one process has many windows, and these are all swapped at once when switching between them (see daemon.c)
+#define PER_WINDOW __attribute__((section("window_state")))
+
 static inline int limit(int x, int min, int max) {
 	if (x<min)
 		return min;
@@ -29,6 +33,9 @@ typedef int Px;
 
 typedef int64_t Nanosec;
 
+// file descriptor
+typedef int Fd;
+
 // this should be unsigned char, but for practical reasons I use char (since most functions take char)
 typedef char utf8;
 
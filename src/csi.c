@@ -2,9 +2,10 @@
 
 #include "common.h"
 #include "ctlseqs2.h"
-#include "tty.h"
+#include "vt.h"
 #include "buffer.h"
 #include "buffer2.h"
+#include "image.h"
 
 // csi sequence:
 // CSI [private] [arguments...] char [char2]
@@ -244,7 +245,47 @@ static void set_private_mode(int mode, bool state) {
 	case 2004: // set bracketed paste mode
 		T.bracketed_paste = state;
 		break;
+	case 2026: // synchronized update
+		T.synchronized = state;
+		break;
+	}
+}
+
+// for DECRQM: 1 = set, 2 = reset, 0 = unknown mode
+static int get_private_mode(int mode) {
+	bool state;
+	switch (mode) {
+	default:
+		return 0;
+	case 1:
+		state = T.app_cursor;
+		break;
+	case 12:
+		state = T.cursor_blink;
+		break;
+	case 25:
+		state = T.show_cursor;
+		break;
+	case 9: case 1000: case 1002: case 1003:
+		state = T.mouse_mode == mode;
+		break;
+	case 1004:
+		state = T.report_focus;
+		break;
+	case 1005: case 1006: case 1015:
+		state = T.mouse_encoding == mode;
+		break;
+	case 1047: case 1049:
+		state = T.current == &T.buffers[1];
+		break;
+	case 2004:
+		state = T.bracketed_paste;
+		break;
+	case 2026:
+		state = T.synchronized;
+		break;
 	}
+	return state ? 1 : 2;
 }
 
 // get the `n`th argument
@@ -283,11 +324,27 @@ void process_csi_command_2(Char c) {
 			break;
 		}
 		break;
+	case '?':
+		switch (P.csi_char) {
+		case '$':
+			switch (c) {
+			case 'p': // request mode (DECRQM)
+				vt_printf("\x1B[?%d;%d$y", P.argv[0], get_private_mode(P.argv[0]));
+				break;
+			default:
+				dump(c);
+				break;
+			}
+			break;
+		default:
+			dump(c);
+			break;
+		}
+		break;
 	}
-	P.state = NORMAL;
 }
 
-static void process_csi_command(Char c) {
+void process_csi_command(Char c) {
 	int arg = P.argv[0]; //will be 0 if no args were passed. this is intentional.
 	
 	switch (P.csi_private) {
@@ -376,6 +433,7 @@ static void process_csi_command(Char c) {
 				break;
 			case 2: // whole screen
 				clear_region(0, 0, T.width, T.height);
+				placements_clear(T.current==&T.buffers[1], 0, T.height);
 				break;
 			case 3: // scollback
 				// ehhh todo
@@ -418,7 +476,7 @@ static void process_csi_command(Char c) {
 			default:
 				goto invalid;
 			case 6:
-				tty_printf("\x1B[%d;%dR", T.c.y+1, T.c.x+1);
+				vt_printf("\x1B[%d;%dR", T.c.y+1, T.c.x+1);
 			}
 			break;
 		case 'P': // delete characters =dch= =dch1=
@@ -447,39 +505,39 @@ static void process_csi_command(Char c) {
 		case 'b': // repeat previous char
 			if (P.last_printed >= 0) {
 				int count = arg01();
-				for (int i=0; i<count; i++)
-					put_char(P.last_printed);
+				Char run[256];
+				FOR (i, (count<LEN(run) ? count : LEN(run)))
+					run[i] = P.last_printed;
+				while (count > 0) {
+					int n = count<LEN(run) ? count : LEN(run);
+					put_chars(n, run);
+					count -= n;
+				}
 			}
 			break;
-		case ' ': case '$': case '#': case '"':
-			P.csi_char = c;
-			P.state = CSI_2;
-			return;
 		}
 	}
-	P.state = NORMAL;
 	return;
  invalid:
 	print("unknown command args: ");
 	dump(c);
-	P.state = NORMAL;
 }
 
-void process_csi_char(Char c) {
+void process_csi_param(Char c) {
 	if (c>='0' && c<='9') { // arg
-		P.argv[P.argc-1] *= 10;
-		P.argv[P.argc-1] += c - '0';
-	} else if (c==':' || c==';') { // arg separator
+		if (P.argv[P.argc-1] < 100000) {
+			P.argv[P.argc-1] *= 10;
+			P.argv[P.argc-1] += c - '0';
+		}
+	} else { // arg separator (`:` or `;`)
 		// the purpose of the colons is to allow for argument grouping.
 		// because all the other codes are a single number, so if they are not supported, it's nbd
 		// but multi-number codes can cause frame shift issues, if they aren't supported, then the terminal will interpret the later values as individual args which is wrong.
 		// so the colons allow you to know how many values to skip in this case
+		if (P.argc >= LEN(P.argv))
+			return; // too many args: ignore the rest
 		P.arg_colon[P.argc-1] = c==':';
 		P.argc++;
 		P.argv[P.argc-1] = 0;
-	} else {
-		// finished
-		P.arg_colon[P.argc-1] = false;
-		process_csi_command(c);
 	}
 }
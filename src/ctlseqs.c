@@ -2,21 +2,22 @@
 #define _XOPEN_SOURCE 500
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 #include "common.h"
 #include "ctlseqs.h"
 #include "ctlseqs2.h"
-#include "tty.h"
 #include "buffer.h"
 #include "buffer2.h"
-#include "draw2.h"
 #include "settings.h"
-// messy
-extern void own_clipboard(utf8* which, utf8* string);
-extern void set_title(utf8* c);
-extern void change_font(const utf8* name);
+#include "vt.h"
+#include "scan.h"
+#include "kitty.h"
+#include "sixel.h"
+#include "base64.h"
+#include "parse_table.h" // generated by gen_parse_table.c
 
-ParseState P;
+PER_WINDOW ParseState P;
 
 // returns true if char was eaten
 bool process_control_char(utf8 c) {
@@ -44,52 +45,52 @@ bool process_control_char(utf8 c) {
 	return true;
 }
 
+// strings are collected in P.string, which is reused.
+// if a string gets longer than its limit (see settings.oscLimit etc.), it's passed to its handler in pieces (see stream_string()), or ignored if it doesn't have one
+static int string_limit(void) {
+	switch (P.string_command) {
+	case OSC:
+		return settings.oscLimit;
+	case DCS:
+		return settings.dcsLimit;
+	case APC:
+		return settings.apcLimit;
+	default: // PM, SOS (ignored)
+		return 0;
+	}
+}
+
 static void begin_string(int type) {
-	P.state = STRING;
-	P.string_size = 1030;
-	ALLOC(P.string, P.string_size);
 	P.string_command = type;
 	P.string_length = 0;
+	P.string_skip = string_limit() <= 0;
+	P.string_streamed = false;
 }
 
-// xterm's VTPrsTbl.c is an interesting idea
-// ex: in the normal state, it looks up each char in `ansi_table`.
-// if it reads ESC, it would look up `ansi_table["\e"]` and switch to that state, which is CASE_ESC
-// then, in that state, it uses `esc_table` to decide how to handle the next char, etc
-
-static void process_escape_char(Char c) {
-	switch (c) {
-		// multi-char sequences
-	case '(': // designate G0-G3 char sets
-	case ')':
-	case '*':
-	case '+':
-		P.state = ALTCHARSET;
-		P.charset = c-'(';
+// make room for `length` bytes, plus a null terminator
+static void reserve_string(int length) {
+	if (P.string_size > length)
 		return;
-	case '[': // CSI
-		P.argc = 1;
-		P.argv[0] = 0;
-		P.csi_private = 0;
-		P.csi_char = 0;
-		P.state = CSI_START;
-		return;
-		
-	// things that take string parameters
-	case 'P': // Device Control String
-		begin_string(DCS);
-		return;
-	case ']': // Operating System Command
-		begin_string(OSC);
-		return;
-	case '^': // Privacy Message
-		begin_string(PM);
+	int size = P.string_size ? P.string_size : 256;
+	while (size <= length)
+		size *= 2;
+	P.string_size = size;
+	REALLOC(P.string, P.string_size);
+}
+
+static void esc_dispatch(Char c) {
+	if (P.csi_char>='(' && P.csi_char<='+') { // designate G0-G3 char sets
+		if (c=='0' || c=='B')
+			select_charset(P.csi_char-'(', c);
+		else
+			print("unknown charset: %s\n", char_name(c));
 		return;
-	case '_': // Application Program Command
-		begin_string(APC);
+	}
+	if (P.csi_char) {
+		print("unknown control sequence: ESC %s %s\n", P.csi_char<0 ? "(...)" : char_name(P.csi_char), char_name(c));
 		return;
-		
-	// single char sequences
+	}
+	switch (c) {
 	case '7': // Save Cursor
 		save_cursor();
 		break;
@@ -112,65 +113,32 @@ static void process_escape_char(Char c) {
 	case 'c': // full reset
 		full_reset();
 		break;
-		
+	case '\\': // String Terminator (the string was already ended by the ESC)
+		break;
 	default:
 		print("unknown control sequence: ESC %s\n", char_name(c));
 	}
-	P.state = NORMAL;
 }
 
-static void process_kitty(int args[128], int length, utf8 data[length]) {
-	print("got kitty data\n");
+static void csi_dispatch(Char c) {
+	P.arg_colon[P.argc-1] = false;
+	if (P.csi_char < 0)
+		print("unknown CSI command (multiple intermediate chars): %s\n", char_name(c));
+	else if (P.csi_char)
+		process_csi_command_2(c);
+	else
+		process_csi_command(c);
 }
 
 static void process_apc(void) {
 	utf8* s = P.string;
 	if (s[0]=='G') { // kitty graphics
-		s++;
-		int args[128] = {
-			['a'] = 't',
-			['f'] = 32,
-			['t'] = 'd',
-		};
-		utf8 key;
-		utf8* valueStart;
-		
-		while (1) {
-			if (*s==';') {// end of key=value parameters
-				s++;
-				break;
-			}
-			if (*s>='a'&&*s<='z' || *s>='A'&&*s<='Z') { // key name
-				key = *s;
-				s++;
-				if (*s=='=') { // =
-					s++;
-					valueStart = s;
-					while (*s!=',' && *s!=';')
-						s++;
-					// now we have the value
-					if (*valueStart=='-' || *valueStart>='0'&&*valueStart<='9') {
-						args[key] = atoi(valueStart); //number
-					} else {
-						args[key] = *valueStart; // just 1 char
-					}
-					if (*s==',')
-						s++;
-					else if (*s!=';') {
-						print("invalid char after value in kitty seq\n");
-						return; // error, invalid character after value
-					}
-				} else {
-					print("missing = after key name '%c' in kitty seq\n", key);
-					return; // error, missing = after key name
-				}
-			} else {
-				print("invalid char in kitty seq\n");
-				return;
-				// idk invalid character
-			}
-		}
-		process_kitty(args, P.string_length-(s-P.string), s);
+		utf8* end = strchr(s, ';');
+		int header = end ? end-s-1 : P.string_length-1;
+		kitty_start(header, s+1);
+		if (end)
+			kitty_data(P.string_length-(end+1-s), end+1);
+		kitty_end();
 	} else {
 		print("unknown APC command (yes i know the C already stands for command shhh)\n");
 	}
@@ -193,34 +161,34 @@ static int parse_number(utf8** str) {
 	//return -1; // fail: found char other than ; or end of string
 }
 
-static utf8* base64_decode(int len, utf8 input[len]) {
-	static const int8_t base64_map[256] = {
-		['='] = 0,
-		['A'] = 0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,
-		['a'] = 26,27,28,29,30,31,32,33,34,35,36,37,38,39,40,41,42,43,44,45,46,47,48,49,50,51,
-		['0'] = 52,53,54,55,56,57,58,59,60,61,
-		['+'] = 62, ['-'] = 62,
-		['/'] = 62, ['_'] = 63,
-	};
-	utf8* out;
-	ALLOC(out, (len*6+7)/8+1);
-	utf8* p = out;
-	int buffer = 0;
-	int bits = 0;
-	for (int i=0; i<len; i++) {
-		buffer <<= 6;
-		buffer |= base64_map[input[i]];
-		bits += 6;
-		if (bits >= 8) {
-			*p++ = buffer>>bits-8 & 0xFF;
-			bits -= 8;
-		}
-	}
-	if (bits) {
-		// todo
+// OSC 52 clipboard data (decoded as it arrives, if the string is long enough to be streamed)
+PER_WINDOW static utf8* clip_which;
+PER_WINDOW static utf8* clip_data;
+PER_WINDOW static size_t clip_length;
+PER_WINDOW static Base64 clip_base64;
+
+static void start_clip(const utf8* which) {
+	FREE(clip_which);
+	clip_which = strdup(which);
+	FREE(clip_data);
+	clip_length = 0;
+}
+
+static void append_clip(int len, const utf8 base64[len]) {
+	REALLOC(clip_data, clip_length+BASE64_DECODED_SIZE(len)+1);
+	clip_length += base64_decode(&clip_base64, len, base64, (uint8_t*)clip_data+clip_length);
+	clip_data[clip_length] = '\0';
+}
+
+static void finish_clip(void) {
+	if (!base64_end(&clip_base64))
+		print("invalid base64 data in OSC 52\n");
+	else if (vt.own_clipboard && clip_data) {
+		vt.own_clipboard(clip_which, clip_data);
+		clip_data = NULL; // (now owned by the clipboard)
 	}
-	*p = '\0';
-	return out;
+	FREE(clip_data);
+	FREE(clip_which);
 }
 
 static void process_osc(void) {
@@ -237,9 +205,11 @@ static void process_osc(void) {
 	case 0: // set window title + icon title
 		if (*s==';') {
 			s++;
-			set_title(s);
+			if (vt.set_title)
+				vt.set_title(s);
 		} else
-			set_title(NULL);
+			if (vt.set_title)
+				vt.set_title(NULL);
 		break;
 	case 4: // change palette color
 		while (s && *s==';') {
@@ -251,8 +221,8 @@ static void process_osc(void) {
 				goto invalid;
 			s++;
 			utf8* se = strchr(s, ';');
-			parse_x_color(s, &T.palette[id]);
-			dirty_all();
+			vt_parse_color(s, &T.palette[id]);
+			vt_dirty_all();
 			s = se;
 		}
 		break;
@@ -286,17 +256,18 @@ static void process_osc(void) {
 		// what ??  i dont think this was written correctly..
 		/*while (s && *s==';') {
 			s++;
-			parse_x_color(s, (RGBColor*[]){
+			vt_parse_color(s, (RGBColor*[]){
 				&T.foreground, &T.background, &T.cursor_color
 			}[p-10]);
 			p++;
 		}
-		dirty_all();*/
+		vt_dirty_all();*/
 		break;
 	case 50: // change font
 		if (*s==';') {
 			s++;
-			change_font(s);
+			if (vt.change_font)
+				vt.change_font(s);
 		}
 		break;
 	case 52:; // set clipboard
@@ -306,8 +277,9 @@ static void process_osc(void) {
 		if (se) {
 			*se = '\0';
 			se++;
-			int len = strlen(se);
-			own_clipboard(s, base64_decode(len, se));
+			start_clip(s);
+			append_clip(strlen(se), se);
+			finish_clip();
 		}
 		break;
 	case 104:; // reset palette color
@@ -324,7 +296,7 @@ static void process_osc(void) {
 				T.palette[id] = settings.palette[id];
 			}
 		}
-		dirty_all();
+		vt_dirty_all();
 		break;
 	case 110:; // reset fg color
 		T.foreground = settings.foreground;
@@ -341,101 +313,242 @@ static void process_osc(void) {
 	print("Invalid OSC command: %s\n", P.string);
 }
 
+// pass the collected part of a long string to its handler, and empty the buffer.
+// `last` is set for the final piece. returns false if it can't be handled like this
+static bool stream_string(bool last) {
+	if (P.string_command == DCS && P.string_streamed) {
+		// sixel (the data was already passed to sixel_data() as it arrived)
+		if (last)
+			sixel_end();
+		return true;
+	}
+	if (P.string_command == APC) {
+		// kitty graphics: the payload is decoded as it arrives
+		if (!P.string_streamed) {
+			utf8* end = memchr(P.string, ';', P.string_length);
+			if (P.string[0]!='G' || !end)
+				return false;
+			kitty_start(end-P.string-1, P.string+1);
+			end++;
+			P.string_length -= end-P.string;
+			memmove(P.string, end, P.string_length);
+			P.string_streamed = true;
+		}
+		kitty_data(P.string_length, P.string);
+		P.string_length = 0;
+		if (last)
+			kitty_end();
+		return true;
+	}
+	if (P.string_command != OSC)
+		return false; // nothing else supports this yet
+	
+	if (!P.string_streamed) {
+		// only OSC 52 (set clipboard) is likely to be this long
+		P.string[P.string_length] = '\0';
+		utf8* s = P.string;
+		if (parse_number(&s)!=52 || *s!=';')
+			return false;
+		s++;
+		utf8* se = strchr(s, ';');
+		if (!se)
+			return false;
+		*se = '\0';
+		start_clip(s);
+		se++;
+		P.string_length -= se-P.string;
+		memmove(P.string, se, P.string_length);
+		P.string_streamed = true;
+	}
+	append_clip(P.string_length, P.string);
+	P.string_length = 0;
+	if (last)
+		finish_clip();
+	return true;
+}
+
 static void end_string(void) {
-	P.state = NORMAL;
-	if (!P.string)
+	if (P.string_skip)
 		return;
-	P.string[P.string_length] = '\0';
-	switch (P.string_command) {
-	default:
-		print("unknown string command\n");
-		break;
-	case OSC:
-		process_osc();
-		break;
-	case APC:
-		process_apc();
-		break;
+	if (P.string_streamed) {
+		stream_string(true);
+	} else {
+		reserve_string(P.string_length);
+		P.string[P.string_length] = '\0';
+		switch (P.string_command) {
+		default:
+			print("unknown string command\n");
+			break;
+		case OSC:
+			process_osc();
+			break;
+		case APC:
+			process_apc();
+			break;
+		}
+	}
+	// don't hold on to a lot of memory after a big string
+	if (P.string_size > 65536) {
+		FREE(P.string);
+		P.string_size = 0;
 	}
-	FREE(P.string);
-	P.string_size = 0;
 }
 
-static void push_string_byte(utf8 c) {
-	if (!P.string)
+static void push_string(int len, const utf8 s[len]) {
+	if (P.string_skip)
 		return;
-	if (P.string_length >= P.string_size-1) {
-		if (P.string_size >= 100000) {
-			FREE(P.string);
+	if (P.string_command == DCS && P.string_streamed) {
+		sixel_data(len, s);
+		return;
+	}
+	int limit = string_limit();
+	while (P.string_length+len > limit) {
+		// fill the buffer up to the limit, then try to hand it off
+		int n = limit-P.string_length;
+		reserve_string(limit);
+		memcpy(P.string+P.string_length, s, n);
+		P.string_length = limit;
+		s += n;
+		len -= n;
+		if (!stream_string(false)) {
+			print("control string too long (limit: %d bytes)\n", limit);
+			P.string_skip = true;
 			return;
 		}
-		P.string_size += 1024;
-		REALLOC(P.string, P.string_size);
 	}
-	P.string[P.string_length++] = c;
+	reserve_string(P.string_length+len);
+	memcpy(P.string+P.string_length, s, len);
+	P.string_length += len;
 }
 
-static void process_char(Char c) {
-	if (c<256 && c>=0 && process_control_char(c))
-		return;
-	////////////////////////
-	switch (P.state) {
-		 //normal
-	case NORMAL:
-		switch (c) {
-		case '\x1B':
-			P.state = ESC;
-			break;
-		default:
-			P.last_printed = c; //todo: when to reset this?
-			put_char(c);
+// printable chars are collected here, and written to the screen together (see put_chars())
+PER_WINDOW static Char pending[256];
+PER_WINDOW static int pending_length = 0;
+
+static void flush_pending(void) {
+	if (pending_length) {
+		put_chars(pending_length, pending);
+		pending_length = 0;
+	}
+}
+
+// clear the sequence's parameters
+static void clear(void) {
+	P.argc = 1;
+	P.argv[0] = 0;
+	P.arg_colon[0] = false;
+	P.csi_private = 0;
+	P.csi_char = 0;
+}
+
+static void enter_state(int state, Char c) {
+	switch (state) {
+	case ESCAPE:
+	case CSI_ENTRY:
+	case DCS_ENTRY:
+		clear();
+		break;
+	case DCS_PASSTHROUGH:
+		begin_string(DCS);
+		P.dcs_final = c;
+		// sixel data isn't collected, since it can be very long
+		if (c=='q' && !P.csi_char && !P.csi_private && !P.string_skip) {
+			sixel_start(P.argc, P.argv);
+			P.string_streamed = true;
 		}
 		break;
-		// escape
-	case ESC:
-		process_escape_char(c);
+	case OSC_STRING:
+		begin_string(OSC);
+		break;
+	case SOS_PM_APC_STRING:
+		begin_string(c=='_' ? APC : c=='^' ? PM : SOS);
+		break;
+	}
+}
+
+static void leave_state(int state) {
+	switch (state) {
+	case DCS_PASSTHROUGH:
+	case OSC_STRING:
+	case SOS_PM_APC_STRING:
+		end_string();
 		break;
-	case CSI_START:
-		P.state = CSI;
-		if (c=='?' || c=='>' || c=='!')
+	}
+}
+
+// process one char (or one byte, in a string state) using the state table
+static void step(Char c) {
+	int entry = parse_table[P.state][c<0x100 ? c : 0xFF];
+	int action = entry>>4;
+	int next = entry & 15;
+	
+	if (action == PRINT) { // (never changes the state)
+		if (pending_length == LEN(pending))
+			flush_pending();
+		pending[pending_length++] = c;
+		P.last_printed = c; //todo: when to reset this?
+		return;
+	}
+	// anything else might depend on the screen contents or the cursor position
+	flush_pending();
+	if (next != STAY)
+		leave_state(P.state);
+	switch (action) {
+	case EXECUTE:
+		process_control_char(c);
+		break;
+	case COLLECT:
+		if (c>=0x3C) // private marker
 			P.csi_private = c;
-		else {
-			P.csi_private = 0;
-			process_csi_char(c);
-		}
+		else
+			P.csi_char = P.csi_char ? -1 : c;
 		break;
-	case CSI:
-		process_csi_char(c);
+	case PARAM:
+		process_csi_param(c);
 		break;
-	case CSI_2:
-		process_csi_command_2(c);
+	case ESC_DISPATCH:
+		esc_dispatch(c);
 		break;
-	case ALTCHARSET:
-		if (c=='0' || c=='B')
-			select_charset(P.charset, c);
-		else
-			print("unknown charset: %s\n", char_name(c));
-		P.state = NORMAL;
-		break;
-		// ???
-	case ST:
-		if (c=='\\') { // got ESC+backslash (end string)
-			end_string();
-		} else { // got ESC+<some other char> (add to string)
-			// todo: is this really the proper way to handle this
-			push_string_byte('\x1B');
-			push_string_byte(c);
-			P.state = STRING;
-		}
+	case CSI_DISPATCH:
+		csi_dispatch(c);
 		break;
-	default:
-		print("unknown parse state? (%d)\n", P.state);
-		P.state = NORMAL;
+	case PUT:
+		push_string(1, &(utf8){c});
+		break;
+	}
+	if (next != STAY) {
+		P.state = next;
+		enter_state(next, c);
 	}
 }
 
-static Char utf8_buffer = 0;
-static int utf8_remaining = 0;
+#ifdef PARSE_STATS
+ParseStats parse_stats[PARSE_STATES];
+
+const char* parse_state_name(int state) {
+	return parse_state_names[state];
+}
+
+static Nanosec stats_now(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (Nanosec)t.tv_sec*1000*1000*1000 + t.tv_nsec;
+}
+
+// the clock is only read when the state changes, so this doesn't slow down long runs of text
+static int stats_state;
+static Nanosec stats_start;
+
+static void stats_switch(int state) {
+	Nanosec now = stats_now();
+	parse_stats[stats_state].time += now-stats_start;
+	stats_state = state;
+	stats_start = now;
+}
+#endif
+
+PER_WINDOW static Char utf8_buffer = 0;
+PER_WINDOW static int utf8_remaining = 0;
 void process_chars(int len, const utf8 cs[len]) {
 	// 128, 192, 224, 240, 248
 	static const int8_t utf8_type[32] = {
@@ -447,19 +560,82 @@ void process_chars(int len, const utf8 cs[len]) {
 		[31] = -1, // invalid
 	};
 	
+#ifdef PARSE_STATS
+	stats_state = P.state;
+	stats_start = stats_now();
+#endif
 	for (int i=0; i<len; i++) {
 		Char c = (unsigned char)cs[i]; //important! we need to convert to unsigned before casting to int
-		if (P.state == STRING) {
-			// start of ESC \ (string terminator)
-			if (c==0x1B)
-				P.state = ST;
-			// end of string
-			// todo: maybe check other characters here just in case
-			else if (c==0x07 || c==0x18 || c==0x1A || (c>=0x80 && c<=0x9F) || c=='\n') {
-				end_string();
-			} else {
-				push_string_byte(c);
+#ifdef PARSE_STATS
+		if (P.state != stats_state)
+			stats_switch(P.state);
+		parse_stats[P.state].bytes++;
+#endif
+		// fast path: runs of printable ascii text are written to the screen all at once
+		if (P.state == GROUND && utf8_remaining==0 && c>=0x20 && c<0x7F) {
+			flush_pending();
+			size_t n = scan_ascii(len-i, cs+i);
+			put_ascii(n, cs+i);
+			P.last_printed = (unsigned char)cs[i+n-1];
+#ifdef PARSE_STATS
+			parse_stats[P.state].bytes += n-1;
+#endif
+			i += n-1;
+			continue;
+		}
+		// same for utf-8 text
+		if (P.state == GROUND && utf8_remaining==0 && c>=0x80) {
+			static Char decoded[1024];
+			size_t count;
+			size_t n = decode_utf8(len-i<LEN(decoded) ? len-i : LEN(decoded), cs+i, decoded, &count);
+			if (n) {
+				flush_pending();
+				put_chars(count, decoded);
+				P.last_printed = decoded[count-1];
+#ifdef PARSE_STATS
+				parse_stats[P.state].bytes += n-1;
+#endif
+				i += n-1;
+				continue;
 			}
+			// otherwise, it's invalid or cut off, so let the normal decoder handle it
+		}
+		// runs of line breaks: count the newlines and scroll once
+		// (\r only changes x and \n only changes y, so the order doesn't matter)
+		// this only batches unbroken runs. with text between the newlines (log output etc.), each line is still scrolled by itself:
+		// by then, most of the time per line is spent clearing the row that's reused for the new line (see scroll_screen()), which has to happen anyway before the text is written into it.
+		if (P.state == GROUND && utf8_remaining==0 && (c=='\n' || c=='\r')) {
+			flush_pending();
+			int n = 0, lines = 0;
+			bool cr = false;
+			for (; i+n<len && (cs[i+n]=='\n' || cs[i+n]=='\r'); n++) {
+				if (cs[i+n]=='\n')
+					lines++;
+				else
+					cr = true;
+			}
+			forward_index(lines);
+			if (cr)
+				carriage_return();
+#ifdef PARSE_STATS
+			parse_stats[P.state].bytes += n-1;
+#endif
+			i += n-1;
+			continue;
+		}
+		if (P.state >= DCS_PASSTHROUGH) {
+			// strings are read as raw bytes, and the text between control chars is copied all at once
+			size_t n = scan_string(len-i, cs+i);
+			if (n) {
+				if (P.state != DCS_IGNORE)
+					push_string(n, cs+i);
+#ifdef PARSE_STATS
+				parse_stats[P.state].bytes += n-1;
+#endif
+				i += n-1;
+				continue;
+			}
+			step(c);
 		} else {
 			// outside of a string: start decoding utf-8
 			
@@ -471,7 +647,7 @@ void process_chars(int len, const utf8 cs[len]) {
 					utf8_remaining--;
 					utf8_buffer |= c<<(6*utf8_remaining);
 					if (utf8_remaining==0)
-						process_char(utf8_buffer);
+						step(utf8_buffer);
 				} else {
 					if (DEBUG.utf8)
 						print("Invalid utf8! unexpected continuation byte\n");
@@ -483,11 +659,11 @@ void process_chars(int len, const utf8 cs[len]) {
 				if (utf8_remaining!=0) {
 					if (DEBUG.utf8)
 						print("Invalid utf8! interrupted sequence\n");
-					process_char(0xFFFD);
+					step(0xFFFD);
 				}
 				if (type==0) {
 					utf8_remaining = 0;
-					process_char(c);
+					step(c);
 				} else {
 					utf8_remaining = type-1;
 					utf8_buffer = c<<(6*utf8_remaining);
@@ -495,12 +671,51 @@ void process_chars(int len, const utf8 cs[len]) {
 			}
 		}
 	}
+	flush_pending();
+#ifdef PARSE_STATS
+	stats_switch(P.state);
+#endif
 	//write_char(c[i]);
 }
 
+// save/load the parser state along with the screen (see term_save()), in case a snapshot is taken in the middle of a sequence
+void parser_save(void (*write)(size_t len, const void* data)) {
+	write(sizeof(P), &P);
+	if (P.string)
+		write(P.string_length, P.string);
+	write(sizeof(utf8_buffer), &utf8_buffer);
+	write(sizeof(utf8_remaining), &utf8_remaining);
+}
+
+bool parser_load(bool (*read)(size_t len, void* data)) {
+	FREE(P.string);
+	if (!read(sizeof(P), &P))
+		return false;
+	if (P.string) {
+		if (P.string_length<0 || P.string_length>=P.string_size) {
+			P.string = NULL;
+			return false;
+		}
+		ALLOC(P.string, P.string_size);
+		if (!read(P.string_length, P.string))
+			return false;
+	}
+	// (the state of a string that was being streamed isn't saved)
+	if (P.string_streamed)
+		P.string_skip = true;
+	return read(sizeof(utf8_buffer), &utf8_buffer) && read(sizeof(utf8_remaining), &utf8_remaining);
+}
+
 void reset_parser(void) {
 	utf8_remaining = 0;
 	utf8_buffer = 0;
-	P.state = NORMAL;
+	P.state = GROUND;
 	P.last_printed = -1;
 }
+
+void parser_free(void) {
+	FREE(P.string);
+	P.string_size = 0;
+	FREE(clip_which);
+	FREE(clip_data);
+}
@@ -2,3 +2,16 @@
 
 void process_chars(int len, const utf8 c[len]);
 void reset_parser(void);
+void parser_free(void);
+void parser_save(void (*write)(size_t len, const void* data));
+bool parser_load(bool (*read)(size_t len, void* data));
+
+#ifdef PARSE_STATS
+// (for the benchmark) time spent and bytes processed in each parser state
+typedef struct ParseStats {
+	Nanosec time;
+	uint64_t bytes;
+} ParseStats;
+extern ParseStats parse_stats[];
+const char* parse_state_name(int state);
+#endif
@@ -3,46 +3,76 @@
 
 #include "common.h"
 
+// parser states. this is the DEC ANSI parser from https://vt100.net/emu/dec_ansi_parser (with a few changes, see gen_parse_table.c)
+// the transitions are in a table which is generated at build time
 enum parse_state {
-	NORMAL,
-	ESC,
-	CSI_START,
-	CSI,
-	CSI_2,
-	ESC_TEST,
-	UTF8,
-	ALTCHARSET,
-	STRING,
-	ST,
+	GROUND,
+	ESCAPE,
+	ESCAPE_INTERMEDIATE,
+	CSI_ENTRY,
+	CSI_PARAM,
+	CSI_INTERMEDIATE,
+	CSI_IGNORE,
+	DCS_ENTRY,
+	DCS_PARAM,
+	DCS_INTERMEDIATE,
+	// (the rest of these are strings, where input is read as raw bytes instead of utf-8)
+	DCS_PASSTHROUGH,
+	DCS_IGNORE,
+	OSC_STRING,
+	SOS_PM_APC_STRING,
+	PARSE_STATES,
+	
+	STAY = 15, // (in the table: no state change)
+};
+
+// things to do with a char, in the table
+enum parse_action {
+	IGNORE,
+	PRINT,
+	EXECUTE, // C0 control char
+	COLLECT, // private marker or intermediate char
+	PARAM, // digit or separator
+	ESC_DISPATCH,
+	CSI_DISPATCH,
+	PUT, // add to string
+	PARSE_ACTIONS
 };
 
+// each table entry is: action<<4 | next state
+// (entering or leaving a state can have its own action: see enter_state() and leave_state() in ctlseqs.c)
+#define PARSE_ENTRY(action, state) ((action)<<4 | (state))
+
 enum string_command {
 	DCS = 1,
 	APC,
 	PM,
 	OSC,
+	SOS,
 };
 
 typedef struct ParseState {
 	enum parse_state state;
 	
-	utf8* string;
+	utf8* string; // (reused between strings)
 	int string_size;
 	enum string_command string_command;
 	int string_length;
+	bool string_skip; // ignore the rest of this string
+	bool string_streamed; // the start of this string has already been passed to its handler (see stream_string())
 	
 	int argv[100];
 	bool arg_colon[100];
 	int argc;
-	Char csi_private;
-	Char csi_char;
-	
-	int charset;
+	Char csi_private; // private marker (`<=>?`), or 0
+	Char csi_char; // intermediate char (0x20-0x2F), 0 if none, or -1 if there was more than one (unsupported)
+	Char dcs_final; // the char that started a DCS string, i.e. 'q' for sixel
 	
 	Char last_printed;
 } ParseState;
 
 extern ParseState P;
 
-void process_csi_char(Char c);
+void process_csi_command(Char c);
 void process_csi_command_2(Char c);
+void process_csi_param(Char c);
@@ -0,0 +1,393 @@
+// Daemon mode (`12term -d`, and `12term -c` to open a window)
+// most of the time it takes to open a terminal is spent connecting to X and loading fonts. so, the daemon does that once, and then every window lives in the same process: one X connection, one set of fonts and glyphs (and their GlyphSets on the server), and one event loop.
+// clients send their working directory and environment over a unix socket, and the daemon opens a new window with them.
+
+// the state of one window (screen, parser, pty, pixmaps, etc.) is all in global variables, which are marked with PER_WINDOW (see common.h).
+// those all end up in one linker section, so switching between windows is just copying that section out to the old window's buffer, and copying the new window's buffer in.
+// each window has its own epoll fd (see loop_fd()), which the daemon waits on along with the X connection and the socket.
+
+#define _GNU_SOURCE
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#if defined(__linux)
+ #include <sys/epoll.h>
+#endif
+
+#include "common.h"
+#include "daemon.h"
+#include "x.h"
+#include "loop.h"
+
+extern char** environ;
+
+bool in_daemon = false;
+
+// make sure the other end of a socket is our own user
+bool socket_peer_ok(Fd fd) {
+#if defined(SO_PEERCRED)
+	struct ucred cred;
+	socklen_t len = sizeof(cred);
+	if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len)<0)
+		return false;
+	return cred.uid == getuid();
+#else
+	uid_t uid;
+	gid_t gid;
+	if (getpeereid(fd, &uid, &gid)<0)
+		return false;
+	return uid == getuid();
+#endif
+}
+
+// sockets go in a directory that only we can access: $XDG_RUNTIME_DIR/12term, or /tmp/12term-<uid>
+// (if it exists but belongs to someone else, or other users can get into it, it's not used)
+bool runtime_socket(struct sockaddr_un* addr, const utf8* name) {
+	utf8 dir[sizeof(addr->sun_path)];
+	const utf8* runtime = getenv("XDG_RUNTIME_DIR");
+	if (runtime && runtime[0])
+		snprintf(dir, sizeof(dir), "%s/12term", runtime);
+	else
+		snprintf(dir, sizeof(dir), "/tmp/12term-%d", (int)getuid());
+	if (mkdir(dir, 0700)<0 && errno!=EEXIST) {
+		print("couldn't create %s: %s\n", dir, strerror(errno));
+		return false;
+	}
+	struct stat st;
+	if (lstat(dir, &st)<0 || !S_ISDIR(st.st_mode) || st.st_uid!=getuid() || st.st_mode & 077) {
+		print("not using %s: it isn't a private directory owned by us\n", dir);
+		return false;
+	}
+	*addr = (struct sockaddr_un){.sun_family = AF_UNIX};
+	int n = snprintf(addr->sun_path, sizeof(addr->sun_path), "%s/%s", dir, name);
+	if (n<0 || (size_t)n>=sizeof(addr->sun_path)) {
+		print("socket path too long\n");
+		return false;
+	}
+	return true;
+}
+
+// one daemon per user and display
+static bool socket_address(struct sockaddr_un* addr) {
+	const utf8* display = getenv("DISPLAY");
+	if (!display)
+		display = "";
+	utf8 name[100];
+	snprintf(name, sizeof(name), "daemon-%s", display);
+	// (DISPLAY can be a path, on some systems)
+	for (utf8* c=name; *c; c++)
+		if (*c=='/')
+			*c = '_';
+	return runtime_socket(addr, name);
+}
+
+static bool write_all(Fd fd, size_t len, const utf8* data) {
+	while (len) {
+		ssize_t n = write(fd, data, len);
+		if (n<0) {
+			if (errno==EINTR)
+				continue;
+			return false;
+		}
+		data += n;
+		len -= n;
+	}
+	return true;
+}
+
+// (in the client) ask the daemon for a new window
+// returns false if the daemon isn't running
+bool daemon_client(void) {
+	struct sockaddr_un addr;
+	if (!socket_address(&addr))
+		return false;
+	Fd fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd<0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr))<0) {
+		if (fd>=0)
+			close(fd);
+		return false;
+	}
+	// don't send our environment to just anyone
+	if (!socket_peer_ok(fd)) {
+		print("daemon socket %s belongs to another user!\n", addr.sun_path);
+		close(fd);
+		return false;
+	}
+	utf8 cwd[4096];
+	if (!getcwd(cwd, sizeof(cwd)))
+		strcpy(cwd, "/");
+	bool ok = write_all(fd, strlen(cwd)+1, cwd);
+	for (utf8** e=environ; *e && ok; e++)
+		ok = write_all(fd, strlen(*e)+1, *e);
+	close(fd);
+	return ok;
+}
+
+#if defined(__linux)
+
+// the section containing all the PER_WINDOW variables (these symbols are created by the linker)
+extern char __start_window_state[], __stop_window_state[];
+#define STATE_SIZE (size_t)(__stop_window_state-__start_window_state)
+
+typedef struct Terminal {
+	struct Terminal* next;
+	Window win;
+	Fd fd; // see loop_fd()
+	bool touched; // needs update_window()
+	void* state; // copy of the section, while another window is active
+	utf8* request; // (the strings in env point into this)
+	utf8** env;
+} Terminal;
+
+static Terminal* terminals = NULL;
+static Terminal* current = NULL; // whose state is in the section right now
+static void* blank_state; // the section before any windows were created
+static char** daemon_env;
+
+static Display* display;
+static Fd listen_fd = -1;
+static Fd epoll_fd = -1;
+
+static void switch_to(Terminal* t) {
+	if (t == current)
+		return;
+	if (current)
+		memcpy(current->state, __start_window_state, STATE_SIZE);
+	memcpy(__start_window_state, t ? t->state : blank_state, STATE_SIZE);
+	current = t;
+	// so getenv() etc. sees the client's variables
+	environ = t ? t->env : daemon_env;
+}
+
+static Terminal* find_terminal(Window win) {
+	for (Terminal* t=terminals; t; t=t->next)
+		if (t->win == win)
+			return t;
+	return NULL;
+}
+
+static void epoll_add(Fd fd, void* ptr) {
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &(struct epoll_event){.events = EPOLLIN, .data.ptr = ptr}) < 0)
+		die("epoll_ctl failed: %s\n", strerror(errno));
+}
+
+// request: cwd, then environment variables, as null terminated strings
+static void new_terminal(utf8* request, size_t len) {
+	if (request[len-1]!='\0') {
+		print("invalid client request\n");
+		free(request);
+		return;
+	}
+	Terminal* t;
+	ALLOC(t, 1);
+	*t = (Terminal){.request = request};
+	
+	utf8* cwd = request;
+	int count = 0;
+	for (utf8* s = cwd+strlen(cwd)+1; s < request+len; s += strlen(s)+1)
+		count++;
+	ALLOC(t->env, count+1);
+	count = 0;
+	for (utf8* s = cwd+strlen(cwd)+1; s < request+len; s += strlen(s)+1)
+		t->env[count++] = s;
+	t->env[count] = NULL;
+	
+	t->state = malloc(STATE_SIZE);
+	if (!t->state)
+		die("couldn't allocate window state\n");
+	
+	switch_to(NULL);
+	switch_to(t);
+	// the child process starts in the client's directory
+	if (chdir(cwd)<0)
+		print("couldn't chdir to %s: %s\n", cwd, strerror(errno));
+	open_window();
+	if (chdir("/")<0) {}
+	
+	t->win = W.win;
+	t->fd = loop_fd();
+	t->touched = true;
+	t->next = terminals;
+	terminals = t;
+	epoll_add(t->fd, t);
+	print("opened window %lx\n", t->win);
+}
+
+static void accept_client(void) {
+	Fd client = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+	if (client<0) {
+		if (errno!=EINTR && errno!=EAGAIN)
+			print("accept failed: %s\n", strerror(errno));
+		return;
+	}
+	if (!socket_peer_ok(client)) {
+		print("rejecting client from another user\n");
+		close(client);
+		return;
+	}
+	// everything else waits while we read this, so don't let a client stall us
+	setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &(struct timeval){.tv_sec = 1}, sizeof(struct timeval));
+	
+	size_t size = 4096, len = 0;
+	utf8* buf;
+	ALLOC(buf, size);
+	while (1) {
+		if (len == size) {
+			if (size >= 1<<20) {
+				print("client request too long\n");
+				len = 0;
+				break;
+			}
+			size *= 2;
+			REALLOC(buf, size);
+		}
+		ssize_t n = read(client, buf+len, size-len);
+		if (n<0 && errno==EINTR)
+			continue;
+		if (n<0) {
+			print("reading client request failed: %s\n", strerror(errno));
+			len = 0;
+			break;
+		}
+		if (n==0)
+			break;
+		len += n;
+	}
+	close(client);
+	// (empty requests are ignored. that's just `12term -d` checking if we're running)
+	if (!len) {
+		free(buf);
+		return;
+	}
+	new_terminal(buf, len);
+}
+
+static void destroy_terminal(Terminal* t) {
+	switch_to(t);
+	epoll_ctl(epoll_fd, EPOLL_CTL_DEL, t->fd, NULL);
+	print("closing window %lx\n", t->win);
+	destroy_window();
+	// (the section is now garbage, so don't save it)
+	current = NULL;
+	switch_to(NULL);
+	
+	for (Terminal** p=&terminals; *p; p=&(*p)->next) {
+		if (*p == t) {
+			*p = t->next;
+			break;
+		}
+	}
+	free(t->state);
+	free(t->env);
+	free(t->request);
+	free(t);
+}
+
+// a window that closes just ignores X errors for its old resources, rather than taking everyone else down with it
+static int on_x_error(Display* d, XErrorEvent* e) {
+	utf8 text[200];
+	XGetErrorText(d, e->error_code, text, sizeof(text));
+	print("X error: %s (request %d, resource %lx)\n", text, e->request_code, e->resourceid);
+	return 0;
+}
+
+void daemon_run(void) {
+	struct sockaddr_un addr;
+	if (!socket_address(&addr))
+		die("no usable directory for the daemon socket\n");
+	listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+	if (listen_fd<0)
+		die("socket failed: %s\n", strerror(errno));
+	// if a daemon is already running, don't steal its socket
+	if (connect(listen_fd, (struct sockaddr*)&addr, sizeof(addr))==0)
+		die("daemon is already running (%s)\n", addr.sun_path);
+	close(listen_fd);
+	listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+	unlink(addr.sun_path);
+	if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr))<0 || listen(listen_fd, 16)<0)
+		die("couldn't listen on %s: %s\n", addr.sun_path, strerror(errno));
+	print("daemon listening on %s (%zu bytes per window)\n", addr.sun_path, STATE_SIZE);
+	
+	in_daemon = true;
+	// terminals are children of the daemon, and nobody is waiting for them
+	signal(SIGCHLD, SIG_IGN);
+	if (chdir("/")<0) {}
+	XSetErrorHandler(on_x_error);
+	
+	display = W.d;
+	daemon_env = environ;
+	blank_state = malloc(STATE_SIZE);
+	if (!blank_state)
+		die("couldn't allocate window state\n");
+	memcpy(blank_state, __start_window_state, STATE_SIZE);
+	
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (epoll_fd<0)
+		die("epoll_create failed: %s\n", strerror(errno));
+	static char listen_tag;
+	epoll_add(listen_fd, &listen_tag);
+	epoll_add(XConnectionNumber(display), NULL); // (x events are handled below, we just need to wake up when they arrive)
+	
+	while (1) {
+		XEvent ev;
+		while (XPending(display)) {
+			XNextEvent(display, &ev);
+			Terminal* t = find_terminal(ev.xany.window);
+			if (t)
+				switch_to(t);
+			if (XFilterEvent(&ev, None) || !t)
+				continue;
+			handle_event(&ev);
+			t->touched = true;
+		}
+		
+		Terminal* next;
+		for (Terminal* t=terminals; t; t=next) {
+			next = t->next;
+			if (!t->touched)
+				continue;
+			t->touched = false;
+			switch_to(t);
+			if (window_closing()) {
+				destroy_terminal(t);
+				continue;
+			}
+			update_window();
+			loop_prepare();
+		}
+		
+		struct epoll_event events[32];
+		int n;
+		do {
+			n = epoll_wait(epoll_fd, events, LEN(events), XPending(display) ? 0 : -1);
+		} while (n<0 && errno==EINTR);
+		if (n<0)
+			die("epoll_wait failed: %s\n", strerror(errno));
+		
+		FOR (i, n) {
+			void* ptr = events[i].data.ptr;
+			if (ptr == &listen_tag) {
+				accept_client();
+			} else if (ptr) {
+				Terminal* t = ptr;
+				switch_to(t);
+				loop_wait(false);
+				t->touched = true;
+			}
+		}
+	}
+}
+
+#else
+
+void daemon_run(void) {
+	die("daemon mode is linux only\n");
+}
+
+#endif
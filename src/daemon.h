@@ -0,0 +1,13 @@
+#pragma once
+// Daemon mode
+
+#include <sys/un.h>
+
+#include "common.h"
+
+extern bool in_daemon;
+
+bool socket_peer_ok(Fd fd);
+bool runtime_socket(struct sockaddr_un* addr, const utf8* name);
+__attribute__((noreturn)) void daemon_run(void);
+bool daemon_client(void);
@@ -0,0 +1,63 @@
+// Default settings
+// (these are separate from settings.c, since the emulator core (libvt) uses them, and it can't depend on X)
+
+#include "common.h"
+#include "settings.h"
+
+Settings settings = {
+	.palette = {
+	  // dark colors
+		{  0,  0,  0}, // dark black
+		{170,  0,  0}, // dark red
+		{  0,170,  0}, // dark green
+		{170, 85,  0}, // dark yellow
+		{  0,  0,170}, // dark blue
+		{170,  0,170}, // dark magenta
+		{  0,170,170}, // dark cyan
+		{170,170,170}, // dark white
+		// light colors
+		{ 85, 85, 85}, // light black
+		{255, 85, 85}, // light red
+		{ 85,255, 85}, // light green
+		{255,255, 85}, // light yellow
+		{ 85, 85,255}, // light blue
+		{255, 85,255}, // light magenta
+		{ 85,255,255}, // light cyan
+		{255,255,255}, // light white
+	},
+	.cursorColor = {  0,192,  0},
+	.foreground = {255,255,255},
+	.background = {  0,  0,  0},
+	.cursorShape = 2,
+	.saveLines = 2000,
+	.width = 80,
+	.height = 24,
+	.faceName = "monospace",
+	.faceSize = 12,
+	.hyperlinkCommand = "xdg-open",
+	.termName = "xterm-12term",
+	.oscLimit = 100000,
+	.dcsLimit = 100000,
+	.apcLimit = 100000,
+	.imageMemory = 320,
+};
+
+// fill in the rest of the 256 color palette (these can't be customized)
+void init_default_palette(void) {
+	int p = 16;
+	// 6x6x6 rgb cube
+	const int brightness[6] = {0, 95, 135, 175, 215, 255};
+	for (int i=0; i<6*6*6; i++) {
+		settings.palette[p++] = (RGBColor){
+			brightness[i/6/6 % 6],
+			brightness[i/6 % 6],
+			brightness[i % 6],
+		};
+	}
+	// fill the rest with grayscale
+	for (int i=0; i<256-16-6*6*6; i++) {
+		settings.palette[p++] = (RGBColor) {
+			8 + 10*i, 8 + 10*i, 8 + 10*i,
+		};
+	}
+}
@@ -11,6 +11,8 @@
 #include "draw.h"
 #include "draw2.h"
 #include "event.h"
+#include "latency.h"
+#include "image.h"
 
 #define Glyph Glyph_
 typedef struct Glyph {
@@ -36,16 +38,18 @@ typedef struct DrawRow {
 	XftDraw draw;
 	// to force a redraw 
 	bool redraw;
+	// which parts of which images are drawn in this row (see images_key())
+	uint64_t images;
 } DrawRow;
 
-static DrawRow* rows = NULL;
+PER_WINDOW static DrawRow* rows = NULL;
 
-static Row* blank_row = NULL;
+PER_WINDOW static Row* blank_row = NULL;
 
 // cursor
-static XftDraw cursor_draw = {0, 0};
-static int cursor_width; // in cells
-static int cursor_y; // cells
+PER_WINDOW static XftDraw cursor_draw = {0, 0};
+PER_WINDOW static int cursor_width; // in cells
+PER_WINDOW static int cursor_y; // cells
 
 //Drawable frame_buffer = None;
 //GC fb_gc = None;
@@ -93,6 +97,187 @@ static void draw_destroy(XftDraw draw) {
 }
 // todo: add _replace back? this only gets used on resize so is it worth it, idk?
 
+// == images ==
+// each image is uploaded to the X server once, the first time it's displayed.
+// placements shown at a different size get their own scaled copy, which is kept until the cell size changes.
+// so, drawing (or scrolling) images only takes XRenderComposite calls
+
+typedef struct ImagePicture {
+	Image* image;
+	// for scaled copies: the part of the image, and the size it was scaled to
+	bool scaled;
+	int src_x, src_y, src_w, src_h, width, height;
+	Pixmap pixmap;
+	Picture pict;
+	uint64_t used; // last frame this was drawn in
+} ImagePicture;
+
+PER_WINDOW static ImagePicture* pictures = NULL;
+PER_WINDOW static int pictures_length = 0;
+PER_WINDOW static uint64_t frame = 0;
+PER_WINDOW static GC image_gc = None;
+
+#define MAX_SCALED 64
+
+static Picture create_argb(Px w, Px h, Pixmap* pixmap) {
+	static XRenderPictFormat* format = NULL;
+	if (!format)
+		format = XRenderFindStandardFormat(W.d, PictStandardARGB32);
+	*pixmap = XCreatePixmap(W.d, W.win, w, h, 32);
+	return XRenderCreatePicture(W.d, *pixmap, format, 0, NULL);
+}
+
+static void add_picture(ImagePicture p) {
+	p.used = frame;
+	REALLOC(pictures, pictures_length+1);
+	pictures[pictures_length++] = p;
+}
+
+static void free_picture_at(int n) {
+	XRenderFreePicture(W.d, pictures[n].pict);
+	XFreePixmap(W.d, pictures[n].pixmap);
+	pictures[n] = pictures[--pictures_length];
+}
+
+// the whole image, at its original size
+static Picture image_picture(Image* image) {
+	FOR (i, pictures_length) {
+		if (pictures[i].image==image && !pictures[i].scaled) {
+			pictures[i].used = frame;
+			return pictures[i].pict;
+		}
+	}
+	if (image->width>32767 || image->height>32767)
+		return None; // (too big for a pixmap)
+	
+	Pixmap pixmap;
+	Picture pict = create_argb(image->width, image->height, &pixmap);
+	if (!image_gc)
+		image_gc = XCreateGC(W.d, pixmap, 0, NULL);
+	XImage* xi = XCreateImage(W.d, CopyFromParent, 32, ZPixmap, 0, (char*)image->pixels, image->width, image->height, 32, 0);
+	xi->byte_order = __BYTE_ORDER__==__ORDER_LITTLE_ENDIAN__ ? LSBFirst : MSBFirst; // (Xlib swaps the bytes if the server is different)
+	XPutImage(W.d, pixmap, image_gc, xi, 0, 0, 0, 0, image->width, image->height);
+	xi->data = NULL; // (owned by the Image)
+	XDestroyImage(xi);
+	if (DEBUG.images)
+		print("uploaded image %u (%dx%d)\n", image->id, image->width, image->height);
+	
+	add_picture((ImagePicture){
+		.image = image,
+		.pixmap = pixmap,
+		.pict = pict,
+	});
+	return pict;
+}
+
+// part of an image, scaled to `width`x`height`
+static Picture scaled_picture(Placement* p, Px width, Px height) {
+	int scaled = 0;
+	FOR (i, pictures_length) {
+		ImagePicture* s = &pictures[i];
+		if (!s->scaled)
+			continue;
+		if (s->image==p->image && s->width==width && s->height==height && s->src_x==p->src_x && s->src_y==p->src_y && s->src_w==p->src_w && s->src_h==p->src_h) {
+			s->used = frame;
+			return s->pict;
+		}
+		scaled++;
+	}
+	Picture src = image_picture(p->image);
+	if (!src || width>32767 || height>32767)
+		return None;
+	
+	// forget the least recently used copy, if there are too many
+	if (scaled >= MAX_SCALED) {
+		int oldest = -1;
+		FOR (i, pictures_length)
+			if (pictures[i].scaled && (oldest<0 || pictures[i].used < pictures[oldest].used))
+				oldest = i;
+		free_picture_at(oldest);
+	}
+	
+	Pixmap pixmap;
+	Picture pict = create_argb(width, height, &pixmap);
+	// (the transform maps destination coordinates to source coordinates)
+	XTransform scale = {{
+		{XDoubleToFixed((double)p->src_w/width), 0, XDoubleToFixed(p->src_x)},
+		{0, XDoubleToFixed((double)p->src_h/height), XDoubleToFixed(p->src_y)},
+		{0, 0, XDoubleToFixed(1)},
+	}};
+	XTransform identity = {{
+		{XDoubleToFixed(1), 0, 0},
+		{0, XDoubleToFixed(1), 0},
+		{0, 0, XDoubleToFixed(1)},
+	}};
+	XRenderSetPictureTransform(W.d, src, &scale);
+	XRenderSetPictureFilter(W.d, src, FilterGood, NULL, 0);
+	XRenderComposite(W.d, PictOpSrc, src, None, pict, 0, 0, 0, 0, 0, 0, width, height);
+	XRenderSetPictureTransform(W.d, src, &identity);
+	XRenderSetPictureFilter(W.d, src, FilterNearest, NULL, 0);
+	if (DEBUG.images)
+		print("scaled image %u to %dx%d\n", p->image->id, width, height);
+	
+	add_picture((ImagePicture){
+		.image = p->image,
+		.scaled = true,
+		.src_x = p->src_x, .src_y = p->src_y, .src_w = p->src_w, .src_h = p->src_h,
+		.width = width, .height = height,
+		.pixmap = pixmap,
+		.pict = pict,
+	});
+	return pict;
+}
+
+// called by the core before an image is freed
+void draw_free_image(Image* image) {
+	for (int i=pictures_length-1; i>=0; i--)
+		if (pictures[i].image == image)
+			free_picture_at(i);
+}
+
+// draw the part of each placement that's in row `ry`
+// `below`: draw the ones with a negative z-index (which go under the text). otherwise, the rest
+static void draw_images(XftDraw draw, int ry, int n, Placement* list[n], bool below) {
+	FOR (i, n) {
+		Placement* p = list[i];
+		if ((p->z<0) != below)
+			continue;
+		Px width = p->src_w, height = p->src_h;
+		if (p->scaled) {
+			width = p->cols*W.cw - p->offset_x;
+			height = p->rows*W.ch - p->offset_y;
+		}
+		Picture src;
+		int sx = 0, sy = 0;
+		if (width!=p->src_w || height!=p->src_h) {
+			src = scaled_picture(p, width, height);
+		} else {
+			src = image_picture(p->image);
+			sx = p->src_x;
+			sy = p->src_y;
+		}
+		if (!src)
+			continue;
+		// which rows of the image are in this row of cells
+		Px top = (ry-p->y)*W.ch - p->offset_y;
+		Px y1 = top>0 ? top : 0;
+		Px y2 = top+W.ch<height ? top+W.ch : height;
+		Px x = p->x*W.cw + p->offset_x;
+		Px w = x+width<T.width*W.cw ? width : T.width*W.cw-x;
+		if (y2<=y1 || w<=0)
+			continue;
+		XRenderComposite(W.d, PictOpOver, src, None, draw.pict, sx, sy+y1, 0, 0, W.border+x, y1-top, w, y2-y1);
+	}
+}
+
+// identifies which images are drawn in a row (if this doesn't change, the row doesn't need to be redrawn)
+static uint64_t images_key(int ry, int n, Placement* list[n]) {
+	uint64_t key = n;
+	FOR (i, n)
+		key = key*0x100000001B3 ^ ((uint64_t)list[i]->serial<<32 | (uint32_t)(ry-list[i]->y));
+	return key;
+}
+
 static int cell_fontstyle(const Cell* c) {
 	return (c->attrs.weight==1) | (c->attrs.italic)<<1;
 }
@@ -113,7 +298,7 @@ static void cells_to_glyphs(int len, Cell cells[len], Glyph glyphs[len], bool ca
 }
 
 // these are only used to track the old size in this function
-static int drawn_width = -1, drawn_height = -1;
+PER_WINDOW static int drawn_width = -1, drawn_height = -1;
 void draw_resize(int width, int height, bool charsize) {
 	/* if (frame_buffer) */
 	/* 	XFreePixmap(W.d, frame_buffer); */
@@ -143,6 +328,7 @@ void draw_resize(int width, int height, bool charsize) {
 		}
 		rows[y].draw = draw_create(W.w, W.ch);
 		rows[y].redraw = true;
+		rows[y].images = -1;
 	}
 	
 	resize_row(&blank_row, T.width, 0); // 0 should be old width but whatever
@@ -155,6 +341,10 @@ void draw_resize(int width, int height, bool charsize) {
 		if (cursor_draw.drawable)
 			draw_destroy(cursor_draw);
 		cursor_draw = draw_create(W.cw*2, W.ch);
+		// scaled images are the wrong size now
+		for (int i=pictures_length-1; i>=0; i--)
+			if (pictures[i].scaled)
+				free_picture_at(i);
 	}
 }
 
@@ -260,14 +450,19 @@ void draw_rotate_rows(int y1, int y2, int amount, bool screen_space) {
 		rows[y].redraw = true;
 }
 
-static bool draw_row(int y, Row* row) {
+// `ry`: the row's index in the buffer (see get_row())
+static bool draw_row(int y, Row* row, int ry) {
+	Placement* images[64];
+	int n = row==blank_row ? 0 : placements_in_row(T.current==&T.buffers[1], ry, LEN(images), images);
+	uint64_t key = images_key(ry, n, images);
 	// see if row matches what's drawn onscreen
 	// todo: we don't store the wrap flags in here.
 	// so if you're debugging and want them visible, you must remove this line too
 	// todo: i think this is not working reliably?
-	if (!memcmp(&row->cells, rows[y].cells, sizeof(Cell)*T.width))
+	if (!memcmp(&row->cells, rows[y].cells, sizeof(Cell)*T.width) && key==rows[y].images)
 		return false;
 	memcpy(rows[y].cells, &row->cells, T.width*sizeof(Cell));
+	rows[y].images = key;
 	// if blank_row was passed (special case for scrollback out of bounds things)
 	if (row==blank_row) {
 		draw_rect(rows[y].draw, (Color){.truecolor=true,.rgb=T.background}, 0, 0, W.w, W.ch);
@@ -295,6 +490,8 @@ static bool draw_row(int y, Row* row) {
 	draw_rect(rows[y].draw, (Color){.i = /*row->wrap?-3:*/-2}, W.border+W.cw*T.width, 0, W.border+W.cw, W.ch); // we add W.cw to the border width incase the window is slightly larger than it should be (i.e. in fullscreen)
 	//draw_rect(rows[y].draw, (Color){.i = -3}, W.border+W.cw*row->length, 0, W.border, W.ch);
 	
+	draw_images(rows[y].draw, ry, n, images, true);
+	
 	// draw text
 	// todo: we need to handle combining chars here!!
 	Glyph* specs = rows[y].glyphs;
@@ -310,6 +507,8 @@ static bool draw_row(int y, Row* row) {
 		draw_char_overlays(rows[y].draw, W.border+x*W.cw, row->cells[x]);
 	}
 	
+	draw_images(rows[y].draw, ry, n, images, false);
+	
 	return true;
 }
 
@@ -361,6 +560,8 @@ static void paint_row(int y) {
 }
 
 void draw(bool repaint_all) {
+	latency_draw();
+	frame++;
 	if (DEBUG.redraw)
 		time_log(NULL);
 	if (DEBUG.dirty)
@@ -380,7 +581,7 @@ void draw(bool repaint_all) {
 			row = blank_row;
 		
 		bool paint = false;
-		if (draw_row(y, row)) {
+		if (draw_row(y, row, ry)) {
 			paint = true;
 			if (DEBUG.dirty)
 				print(row==blank_row ? "~" : "#");
@@ -390,6 +591,9 @@ void draw(bool repaint_all) {
 		}
 		if (repaint_all || paint || T.c.y == y || rows[y].redraw)
 			paint_row(y);
+		// (the first row with new contents to be copied to the window)
+		if (paint)
+			latency_paint();
 	}
 	if (DEBUG.dirty)
 		print("] ");
@@ -399,8 +603,26 @@ void draw(bool repaint_all) {
 	//time_log("comp");
 }
 
+// free the window's pixmaps and pictures
+// (this matters in daemon mode, where the X connection stays open after the window is closed)
 void draw_free(void) {
-	// whatever
+	FOR (y, drawn_height) {
+		FREE(rows[y].glyphs);
+		FREE(rows[y].cells);
+		draw_destroy(rows[y].draw);
+	}
+	FREE(rows);
+	drawn_height = drawn_width = -1;
+	FREE(blank_row);
+	if (cursor_draw.drawable)
+		draw_destroy(cursor_draw);
+	cursor_draw = (XftDraw){0, 0};
+	while (pictures_length)
+		free_picture_at(pictures_length-1);
+	FREE(pictures);
+	if (image_gc)
+		XFreeGC(W.d, image_gc);
+	image_gc = None;
 }
 
 void dirty_cursor(void) {
@@ -1,8 +1,10 @@
 // x event handler functions and related
 
+#define _POSIX_C_SOURCE 200112L
 #include <X11/Xlib.h>
 #include <X11/Xcursor/Xcursor.h>
 #include <sys/types.h>
+#include <signal.h>
 #include <unistd.h>
 #include <stdio.h>
 #include <string.h>
@@ -16,6 +18,9 @@
 #include "draw.h"
 #include "settings.h"
 #include "clipboard.h"
+#include "frame.h"
+#include "loop.h"
+#include "latency.h"
 
 void activate_hyperlink(const char* url) {
 	if (!settings.hyperlinkCommand)
@@ -26,6 +31,12 @@ void activate_hyperlink(const char* url) {
 		return;
 	}
 	if (pid==0) { // child
+		// signals handled by the event loop are blocked in our process, don't pass that on
+		sigset_t none;
+		sigemptyset(&none);
+		sigprocmask(SIG_SETMASK, &none, NULL);
+		// (the daemon ignores SIGCHLD, and that would be inherited too)
+		signal(SIGCHLD, SIG_DFL);
 		close(0);
 		close(1);
 		close(2);
@@ -58,7 +69,7 @@ static bool cell_at(Px x, Px y, int* ox, int* oy) {
 }
 
 // returns true if the event was eaten
-int ox=-1, oy=-1, oldbutton = 3;
+PER_WINDOW int ox=-1, oy=-1, oldbutton = 3;
 static bool mouse_event(XEvent* ev) {
 	//#undef Cursor
 	//	Cursor c = XcursorLibraryLoadCursor(W.d, "box_spiral");
@@ -185,12 +196,14 @@ static void on_configurenotify(XEvent* e) {
 static void on_clientmessage(XEvent* e) {
 	if (e->xclient.data.l[0] == W.atoms.wm_delete_window) {
 		print("window closing\n");
-		sleep_forever(true);
+		close_window(true);
 	}
 }
 
-struct Ime {
-	XIM xim;
+// (in daemon mode, all the windows share one input method, and each has its own input context)
+static XIM xim;
+
+PER_WINDOW struct Ime {
 	XIC xic;
 	XPoint spot;
 	XVaNestedList spotlist;
@@ -224,9 +237,31 @@ static bool match_modifiers(KeyMap* want, int got) {
 	return true;
 }
 
+// measure how long keypresses waited before we got to them (DEBUG_12TERM=input)
+// X event timestamps come from the server's clock (in ms), so we keep track of the smallest difference seen between that and our clock, and measure delays relative to that
+static void measure_key_wait(Time time) {
+	static Nanosec offset = INT64_MAX;
+	static Nanosec total = 0, max = 0;
+	static int count = 0;
+	Nanosec diff = loop_now()/1000/1000 - (Nanosec)time;
+	if (diff < offset)
+		offset = diff;
+	Nanosec wait = diff - offset;
+	total += wait;
+	if (wait > max)
+		max = wait;
+	count++;
+	if (DEBUG.input)
+		print("key waited %lld ms in queue (average: %.1f ms, max: %lld ms, %d keys)\n", (long long)wait, total/(double)count, (long long)max, count);
+}
+
 void on_keypress(XEvent* ev) {
 	XKeyEvent* e = &ev->xkey;
 	
+	frame_input();
+	measure_key_wait(e->time);
+	latency_key();
+	
 	KeySym ksym;
 	char buf[1024] = {0};
 	int len = 0;
@@ -296,10 +331,11 @@ void on_focusout(XEvent* e) {
 
 static void ximinstantiate(Display* d, XPointer client, XPointer call);
 
-static void ximdestroy(XIM xim, XPointer client, XPointer call) {
-	ime.xim = NULL;
+static void ximdestroy(XIM im, XPointer client, XPointer call) {
+	xim = NULL;
 	XRegisterIMInstantiateCallback(W.d, NULL, NULL, NULL, ximinstantiate, NULL);
 	XFree(ime.spotlist);
+	ime.spotlist = NULL;
 }
 
 static int xicdestroy(XIC xim, XPointer client, XPointer call) {
@@ -308,26 +344,29 @@ static int xicdestroy(XIC xim, XPointer client, XPointer call) {
 }
 
 static bool ximopen(Display* d) {
-	ime.xim = XOpenIM(d, NULL, NULL, NULL);
-	if (!ime.xim) {
-		// in case your XMODIFIERS env var is set incorrectly (i.e. you just uninstalled ibus but it's still set to "@im=ibus")
-		// we try loading it again with that setting overridden
-		// which will use xim
-		XSetLocaleModifiers("@im=none");
-		ime.xim = XOpenIM(d, NULL, NULL, NULL);
-		if (!ime.xim) {
-			print("no input method\n");
-			return false;
+	if (!xim) {
+		xim = XOpenIM(d, NULL, NULL, NULL);
+		if (!xim) {
+			// in case your XMODIFIERS env var is set incorrectly (i.e. you just uninstalled ibus but it's still set to "@im=ibus")
+			// we try loading it again with that setting overridden
+			// which will use xim
+			XSetLocaleModifiers("@im=none");
+			xim = XOpenIM(d, NULL, NULL, NULL);
+			if (!xim) {
+				print("no input method\n");
+				return false;
+			}
 		}
+		
+		if (XSetIMValues(xim, XNDestroyCallback, &(XIMCallback){.callback = ximdestroy}, NULL))
+			print("XSetIMValues: Could not set XNDestroyCallback.\n");
 	}
 	
-	if (XSetIMValues(ime.xim, XNDestroyCallback, &(XIMCallback){.callback = ximdestroy}, NULL))
-		print("XSetIMValues: Could not set XNDestroyCallback.\n");
-	
-	ime.spotlist = XVaCreateNestedList(0, XNSpotLocation, &ime.spot, NULL);
+	if (!ime.spotlist)
+		ime.spotlist = XVaCreateNestedList(0, XNSpotLocation, &ime.spot, NULL);
 	
 	if (ime.xic == NULL) {
-		ime.xic = XCreateIC(ime.xim, XNInputStyle,
+		ime.xic = XCreateIC(xim, XNInputStyle,
 			XIMPreeditNothing | XIMStatusNothing,
 			XNClientWindow, W.win,
 			XNDestroyCallback, &(XICCallback){.callback = xicdestroy},
@@ -351,6 +390,16 @@ void init_input(void) {
 	}
 }
 
+// destroy the window's input context (the input method stays open)
+void free_input(void) {
+	if (ime.xic)
+		XDestroyIC(ime.xic);
+	ime.xic = NULL;
+	if (ime.spotlist)
+		XFree(ime.spotlist);
+	ime.spotlist = NULL;
+}
+
 const HandlerFunc HANDLERS[LASTEvent] = {
 	[ClientMessage] = on_clientmessage,
 	[Expose] = on_expose,
@@ -8,5 +8,6 @@ extern const HandlerFunc HANDLERS[LASTEvent];
 
 void xim_spot(int x, int y);
 void init_input(void);
+void free_input(void);
 void clippaste(void);
 //void simplecopy(void);
@@ -0,0 +1,92 @@
+// Frame scheduling
+// decides when to redraw, and how long the parser can run between frames:
+// - output that arrives soon after a keypress (i.e. echo), or small writes in general, are drawn right away
+// - while a program is flooding output, frames are spaced further apart (up to MAX_INTERVAL), and the parser gets most of each frame, so we don't waste time drawing frames nobody will see
+
+#include "common.h"
+#include "frame.h"
+#include "loop.h"
+
+#define MS (1000*1000)
+// normal minimum time between frames
+#define MIN_INTERVAL (4*MS)
+// longest we'll go without drawing a frame while output is flooding in
+#define MAX_INTERVAL (33*MS)
+// output this long after a keypress isn't considered a response to it
+#define RESPONSE_WINDOW (200*MS)
+// more than this much output per frame means we're flooding
+#define FLOOD_BYTES (64<<10)
+// parse time budget per frame for interactive use (keeps echo from waiting behind a big chunk of output)
+#define MIN_BUDGET (2*MS)
+
+PER_WINDOW static struct {
+	Nanosec interval; // current minimum time between frames
+	Nanosec input_time; // when the last key was pressed, if no output has been seen since then
+	Nanosec turnaround; // average time between a keypress and the first output after it
+	Nanosec draw_time; // average time taken by draw()
+	size_t frame_bytes; // output parsed since the last frame
+	bool more; // a read ran out of budget since the last frame
+	bool urgent; // draw the next frame asap
+	bool flooding;
+} F = {
+	.interval = MIN_INTERVAL,
+};
+
+// call when user input is sent to the child
+void frame_input(void) {
+	F.input_time = loop_now();
+}
+
+// call after output from the child is parsed
+void frame_output(size_t bytes, bool more) {
+	F.frame_bytes += bytes;
+	F.more |= more;
+	if (F.input_time) {
+		Nanosec t = loop_now() - F.input_time;
+		F.input_time = 0;
+		if (t < RESPONSE_WINDOW) {
+			F.turnaround = F.turnaround ? (F.turnaround*7 + t)/8 : t;
+			F.urgent = true;
+			if (DEBUG.redraw)
+				print("input turnaround: %.2f ms (average: %.2f ms)\n", t/(double)MS, F.turnaround/(double)MS);
+		}
+	}
+	if (!F.flooding && !more && bytes < FLOOD_BYTES)
+		F.urgent = true;
+}
+
+// call after a frame is drawn
+void frame_drawn(Nanosec draw_time) {
+	F.draw_time = F.draw_time ? (F.draw_time*7 + draw_time)/8 : draw_time;
+	bool flooding = F.more || F.frame_bytes >= FLOOD_BYTES;
+	// back off quickly, and recover quickly once the flood stops
+	if (flooding)
+		F.interval = F.interval*2 < MAX_INTERVAL ? F.interval*2 : MAX_INTERVAL;
+	else
+		F.interval = MIN_INTERVAL;
+	if (DEBUG.redraw && flooding != F.flooding)
+		print("frame scheduler: %s\n", flooding ? "throughput mode" : "interactive mode");
+	F.flooding = flooding;
+	F.frame_bytes = 0;
+	F.more = false;
+	F.urgent = false;
+}
+
+// the earliest time the next frame should be drawn
+Nanosec frame_next(Nanosec last_draw) {
+	if (F.urgent && !F.flooding)
+		return last_draw;
+	// (when flooding, echo still gets a frame sooner than usual)
+	if (F.urgent)
+		return last_draw + MIN_INTERVAL;
+	return last_draw + F.interval;
+}
+
+// how long the parser may run before we check whether it's time to draw
+Nanosec frame_parse_budget(void) {
+	// if a key was just pressed, keep reads short so its echo isn't stuck behind other output
+	if (!F.flooding || F.input_time)
+		return MIN_BUDGET;
+	Nanosec budget = F.interval - F.draw_time;
+	return budget > MIN_BUDGET ? budget : MIN_BUDGET;
+}
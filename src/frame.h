@@ -0,0 +1,10 @@
+#pragma once
+// Frame scheduling
+
+#include "common.h"
+
+void frame_input(void);
+void frame_output(size_t bytes, bool more);
+void frame_drawn(Nanosec draw_time);
+Nanosec frame_next(Nanosec last_draw);
+Nanosec frame_parse_budget(void);
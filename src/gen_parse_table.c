@@ -0,0 +1,185 @@
+// Generates the parser's state transition table (parse_table.h, included by ctlseqs.c)
+// this is run at build time (see the makefile)
+// `gen_parse_table -dot` prints the state graph instead, for graphviz
+
+// the state machine is the one from https://vt100.net/emu/dec_ansi_parser, except:
+// - outside of strings, the input is unicode (decoded from utf-8), so there are no C1 controls.
+//   all codepoints >= 0x80 use column 0xFF: they're printed in the ground state, and ignored elsewhere
+// - inside strings, the input is raw bytes, and 0x80-0xFF are part of the string
+// - strings can also be ended by BEL (like xterm). OSC/PM/APC strings are ended by a newline too, so a broken sequence doesn't swallow all the output after it
+// - `:` is allowed in parameters (used by SGR)
+// - DEL is part of the string in DCS passthrough (so that every string state can copy everything from 0x20 to 0xFF at once)
+// - DEL is printed in the ground state (as before)
+
+#include <stdio.h>
+#include <string.h>
+
+#include "common.h"
+#include "ctlseqs2.h"
+
+static const char* state_names[PARSE_STATES] = {
+	"GROUND", "ESCAPE", "ESCAPE_INTERMEDIATE",
+	"CSI_ENTRY", "CSI_PARAM", "CSI_INTERMEDIATE", "CSI_IGNORE",
+	"DCS_ENTRY", "DCS_PARAM", "DCS_INTERMEDIATE", "DCS_PASSTHROUGH", "DCS_IGNORE",
+	"OSC_STRING", "SOS_PM_APC_STRING",
+};
+
+static const char* action_names[PARSE_ACTIONS] = {
+	"ignore", "print", "execute", "collect", "param", "esc_dispatch", "csi_dispatch", "put",
+};
+
+static uint8_t table[PARSE_STATES][256];
+
+// set the entries for chars `first` to `last` (inclusive)
+static void on(int state, int first, int last, int action, int next) {
+	for (int c=first; c<=last; c++)
+		table[state][c] = PARSE_ENTRY(action, next);
+}
+
+// C0 controls (except CAN, SUB, ESC, which are handled in every state)
+static void on_c0(int state, int action, int next) {
+	on(state, 0x00, 0x17, action, next);
+	on(state, 0x19, 0x19, action, next);
+	on(state, 0x1C, 0x1F, action, next);
+}
+
+static void build(void) {
+	FOR (s, PARSE_STATES) {
+		on(s, 0x00, 0xFF, IGNORE, STAY);
+		// "anywhere" transitions
+		on(s, 0x18, 0x18, EXECUTE, GROUND);
+		on(s, 0x1A, 0x1A, EXECUTE, GROUND);
+		on(s, 0x1B, 0x1B, IGNORE, ESCAPE);
+	}
+
+	on_c0(GROUND, EXECUTE, STAY);
+	on(GROUND, 0x20, 0xFF, PRINT, STAY);
+
+	on_c0(ESCAPE, EXECUTE, STAY);
+	on(ESCAPE, 0x20, 0x2F, COLLECT, ESCAPE_INTERMEDIATE);
+	on(ESCAPE, 0x30, 0x7E, ESC_DISPATCH, GROUND);
+	on(ESCAPE, '[', '[', IGNORE, CSI_ENTRY);
+	on(ESCAPE, ']', ']', IGNORE, OSC_STRING);
+	on(ESCAPE, 'P', 'P', IGNORE, DCS_ENTRY);
+	on(ESCAPE, 'X', 'X', IGNORE, SOS_PM_APC_STRING);
+	on(ESCAPE, '^', '^', IGNORE, SOS_PM_APC_STRING);
+	on(ESCAPE, '_', '_', IGNORE, SOS_PM_APC_STRING);
+	on(ESCAPE, 0x80, 0xFF, IGNORE, GROUND);
+
+	on_c0(ESCAPE_INTERMEDIATE, EXECUTE, STAY);
+	on(ESCAPE_INTERMEDIATE, 0x20, 0x2F, COLLECT, STAY);
+	on(ESCAPE_INTERMEDIATE, 0x30, 0x7E, ESC_DISPATCH, GROUND);
+	on(ESCAPE_INTERMEDIATE, 0x80, 0xFF, IGNORE, GROUND);
+
+	on_c0(CSI_ENTRY, EXECUTE, STAY);
+	on(CSI_ENTRY, 0x20, 0x2F, COLLECT, CSI_INTERMEDIATE);
+	on(CSI_ENTRY, 0x30, 0x3B, PARAM, CSI_PARAM);
+	on(CSI_ENTRY, 0x3C, 0x3F, COLLECT, CSI_PARAM);
+	on(CSI_ENTRY, 0x40, 0x7E, CSI_DISPATCH, GROUND);
+	on(CSI_ENTRY, 0x80, 0xFF, IGNORE, CSI_IGNORE);
+
+	on_c0(CSI_PARAM, EXECUTE, STAY);
+	on(CSI_PARAM, 0x20, 0x2F, COLLECT, CSI_INTERMEDIATE);
+	on(CSI_PARAM, 0x30, 0x3B, PARAM, STAY);
+	on(CSI_PARAM, 0x3C, 0x3F, IGNORE, CSI_IGNORE);
+	on(CSI_PARAM, 0x40, 0x7E, CSI_DISPATCH, GROUND);
+	on(CSI_PARAM, 0x80, 0xFF, IGNORE, CSI_IGNORE);
+
+	on_c0(CSI_INTERMEDIATE, EXECUTE, STAY);
+	on(CSI_INTERMEDIATE, 0x20, 0x2F, COLLECT, STAY);
+	on(CSI_INTERMEDIATE, 0x30, 0x3F, IGNORE, CSI_IGNORE);
+	on(CSI_INTERMEDIATE, 0x40, 0x7E, CSI_DISPATCH, GROUND);
+	on(CSI_INTERMEDIATE, 0x80, 0xFF, IGNORE, CSI_IGNORE);
+
+	on_c0(CSI_IGNORE, EXECUTE, STAY);
+	on(CSI_IGNORE, 0x40, 0x7E, IGNORE, GROUND);
+
+	on(DCS_ENTRY, 0x20, 0x2F, COLLECT, DCS_INTERMEDIATE);
+	on(DCS_ENTRY, 0x30, 0x3B, PARAM, DCS_PARAM);
+	on(DCS_ENTRY, 0x3C, 0x3F, COLLECT, DCS_PARAM);
+	on(DCS_ENTRY, 0x40, 0x7E, IGNORE, DCS_PASSTHROUGH);
+	on(DCS_ENTRY, 0x80, 0xFF, IGNORE, DCS_IGNORE);
+
+	on(DCS_PARAM, 0x20, 0x2F, COLLECT, DCS_INTERMEDIATE);
+	on(DCS_PARAM, 0x30, 0x3B, PARAM, STAY);
+	on(DCS_PARAM, 0x3C, 0x3F, IGNORE, DCS_IGNORE);
+	on(DCS_PARAM, 0x40, 0x7E, IGNORE, DCS_PASSTHROUGH);
+	on(DCS_PARAM, 0x80, 0xFF, IGNORE, DCS_IGNORE);
+
+	on(DCS_INTERMEDIATE, 0x20, 0x2F, COLLECT, STAY);
+	on(DCS_INTERMEDIATE, 0x30, 0x3F, IGNORE, DCS_IGNORE);
+	on(DCS_INTERMEDIATE, 0x40, 0x7E, IGNORE, DCS_PASSTHROUGH);
+	on(DCS_INTERMEDIATE, 0x80, 0xFF, IGNORE, DCS_IGNORE);
+
+	on_c0(DCS_PASSTHROUGH, PUT, STAY);
+	on(DCS_PASSTHROUGH, 0x20, 0xFF, PUT, STAY);
+	on(DCS_PASSTHROUGH, 0x07, 0x07, IGNORE, GROUND);
+
+	on(DCS_IGNORE, 0x07, 0x07, IGNORE, GROUND);
+
+	on(OSC_STRING, 0x20, 0xFF, PUT, STAY);
+	on(OSC_STRING, 0x07, 0x07, IGNORE, GROUND);
+	on(OSC_STRING, '\n', '\n', IGNORE, GROUND);
+
+	on(SOS_PM_APC_STRING, 0x20, 0xFF, PUT, STAY);
+	on(SOS_PM_APC_STRING, 0x07, 0x07, IGNORE, GROUND);
+	on(SOS_PM_APC_STRING, '\n', '\n', IGNORE, GROUND);
+}
+
+static void print_table(void) {
+	printf("// generated by gen_parse_table.c. don't edit this\n\n");
+	printf("static const uint8_t parse_table[PARSE_STATES][256] = {\n");
+	FOR (s, PARSE_STATES) {
+		printf("\t[%s] = {", state_names[s]);
+		FOR (c, 256) {
+			if (c%16 == 0)
+				printf("\n\t\t");
+			printf("0x%02X,", table[s][c]);
+		}
+		printf("\n\t},\n");
+	}
+	printf("};\n\n");
+	printf("static const char* const parse_state_names[PARSE_STATES] = {\n");
+	FOR (s, PARSE_STATES)
+		printf("\t\"%s\",\n", state_names[s]);
+	printf("};\n");
+}
+
+static void char_label(int c, char out[8]) {
+	if (c>0x20 && c<0x7F && c!='"' && c!='\\')
+		sprintf(out, "%c", c);
+	else
+		sprintf(out, "%02X", c);
+}
+
+// one edge per run of chars with the same action and target
+static void print_dot(void) {
+	printf("digraph parser {\n");
+	printf("\trankdir=LR;\n");
+	FOR (s, PARSE_STATES) {
+		for (int c=0; c<256; ) {
+			int entry = table[s][c];
+			int end = c;
+			while (end+1<256 && table[s][end+1]==entry)
+				end++;
+			int action = entry>>4, next = entry & 15;
+			if (action!=IGNORE || next!=STAY) {
+				char a[8], b[8];
+				char_label(c, a);
+				char_label(end, b);
+				printf("\t%s -> %s [label=\"%s%s%s %s\"];\n", state_names[s], state_names[next==STAY ? s : next], a, c==end ? "" : "-", c==end ? "" : b, action_names[action]);
+			}
+			c = end+1;
+		}
+	}
+	printf("}\n");
+}
+
+int main(int argc, char* argv[argc+1]) {
+	build();
+	if (argc>1 && !strcmp(argv[1], "-dot"))
+		print_dot();
+	else
+		print_table();
+	return 0;
+}
@@ -0,0 +1,238 @@
+// Image storage
+// images are kept in memory until they're deleted, or until the total size goes over the limit (settings.imageMemory), in which case the least recently used ones are removed
+// placements (where images are displayed) are stored here too, since they need to go away along with their image
+
+#include <string.h>
+
+#include "common.h"
+#include "image.h"
+#include "settings.h"
+#include "vt.h"
+
+PER_WINDOW static Image** images = NULL;
+PER_WINDOW static int images_length = 0;
+PER_WINDOW static size_t memory_used = 0;
+PER_WINDOW static uint64_t use_clock = 0; // incremented whenever an image is created or used
+
+PER_WINDOW static Placement** placements = NULL;
+PER_WINDOW static int placements_length = 0;
+PER_WINDOW static uint32_t placement_serial = 0;
+
+static void remove_placement_at(int n) {
+	free(placements[n]);
+	placements[n] = placements[--placements_length];
+}
+
+static int placement_count(Image* image) {
+	int count = 0;
+	FOR (i, placements_length)
+		if (placements[i]->image == image)
+			count++;
+	return count;
+}
+
+// remove a placement, and its image too if it's temporary and isn't shown anywhere else
+static void drop_placement_at(int n, bool free_image) {
+	Image* image = placements[n]->image;
+	remove_placement_at(n);
+	if ((free_image || image->temporary) && !placement_count(image))
+		image_delete(image);
+}
+
+static size_t image_size(Image* image) {
+	return (size_t)image->width*image->height*sizeof(uint32_t);
+}
+
+// max total size of all images, in bytes
+size_t image_quota(void) {
+	return (size_t)settings.imageMemory*1024*1024;
+}
+
+static void remove_at(int n) {
+	Image* image = images[n];
+	if (DEBUG.images)
+		print("deleting image %u (%dx%d)\n", image->id, image->width, image->height);
+	for (int i=placements_length-1; i>=0; i--)
+		if (placements[i]->image == image)
+			remove_placement_at(i);
+	vt_free_image(image);
+	memory_used -= image_size(image);
+	free(image->pixels);
+	free(image);
+	images[n] = images[--images_length];
+}
+
+static void evict_lru(void) {
+	int oldest = 0;
+	FOR (i, images_length)
+		if (images[i]->used < images[oldest]->used)
+			oldest = i;
+	if (DEBUG.images)
+		print("over image memory limit, ");
+	remove_at(oldest);
+}
+
+// add a new (blank) image. if an image with the same id exists, it's replaced
+// returns NULL if it's too large
+Image* image_create(uint32_t id, uint32_t number, int width, int height) {
+	if (width<=0 || height<=0 || (size_t)width*height > image_quota()/sizeof(uint32_t))
+		return NULL;
+	Image* old = image_find(id);
+	if (old)
+		image_delete(old);
+	
+	Image* image;
+	ALLOC(image, 1);
+	*image = (Image){
+		.id = id,
+		.number = number,
+		.width = width,
+		.height = height,
+		.used = ++use_clock,
+		.created = use_clock,
+	};
+	image->pixels = calloc((size_t)width*height, sizeof(uint32_t));
+	if (!image->pixels) {
+		free(image);
+		return NULL;
+	}
+	while (images_length && memory_used+image_size(image) > image_quota())
+		evict_lru();
+	REALLOC(images, images_length+1);
+	images[images_length++] = image;
+	memory_used += image_size(image);
+	if (DEBUG.images)
+		print("new image %u (%dx%d), %zu bytes used\n", id, width, height, memory_used);
+	return image;
+}
+
+Image* image_find(uint32_t id) {
+	FOR (i, images_length)
+		if (images[i]->id == id)
+			return images[i];
+	return NULL;
+}
+
+// (if there are multiple images with the same number, this finds the newest one)
+Image* image_find_number(uint32_t number) {
+	Image* found = NULL;
+	FOR (i, images_length)
+		if (images[i]->number == number && (!found || images[i]->created > found->created))
+			found = images[i];
+	return found;
+}
+
+// returns an id that isn't used by any image
+uint32_t image_free_id(void) {
+	static uint32_t next = 0;
+	do {
+		next++;
+		if (next >= 1u<<31) // (the high ids are left for programs to use)
+			next = 1;
+	} while (image_find(next));
+	return next;
+}
+
+// mark an image as recently used
+void image_touch(Image* image) {
+	image->used = ++use_clock;
+}
+
+void image_delete(Image* image) {
+	FOR (i, images_length)
+		if (images[i] == image) {
+			remove_at(i);
+			return;
+		}
+}
+
+void image_delete_all(void) {
+	while (images_length)
+		remove_at(images_length-1);
+}
+
+size_t image_memory_used(void) {
+	return memory_used;
+}
+
+// size of a cell in pixels (to work out how many cells an image covers)
+void image_cell_size(int* width, int* height) {
+	*width = T.cell_width>0 ? T.cell_width : 10; // (guess, if the frontend didn't say)
+	*height = T.cell_height>0 ? T.cell_height : 20;
+}
+
+// == placements ==
+
+// add a placement of `image` (the caller fills in the position etc.)
+// if `id` is set, and that image already has a placement with the same id, it's replaced
+Placement* placement_create(Image* image, uint32_t id, int buffer) {
+	Placement* p = NULL;
+	if (id)
+		FOR (i, placements_length)
+			if (placements[i]->image == image && placements[i]->id == id) {
+				p = placements[i];
+				break;
+			}
+	if (!p) {
+		ALLOC(p, 1);
+		REALLOC(placements, placements_length+1);
+		placements[placements_length++] = p;
+	}
+	*p = (Placement){
+		.image = image,
+		.id = id,
+		.serial = ++placement_serial,
+		.buffer = buffer,
+	};
+	return p;
+}
+
+
+// delete the placements where match() returns true
+// if `free_images` is set, images that don't have any placements left afterwards are deleted too
+void placements_delete_where(bool (*match)(const Placement* p, const void* data), const void* data, bool free_images) {
+	for (int i=placements_length-1; i>=0; i--) {
+		if (i>=placements_length || !match(placements[i], data))
+			continue;
+		drop_placement_at(i, free_images);
+	}
+}
+
+// delete the placements anchored in rows [`y1`,`y2`)
+void placements_clear(int buffer, int y1, int y2) {
+	for (int i=placements_length-1; i>=0; i--) {
+		Placement* p = placements[i];
+		if (p->buffer==buffer && p->y>=y1 && p->y<y2)
+			drop_placement_at(i, false);
+	}
+}
+
+// move the placements anchored in rows [`y1`,`y2`) by `amount` (to follow the text when it scrolls)
+// ones that are moved past `y2` or above `top` are deleted
+void placements_shift(int buffer, int y1, int y2, int amount, int top) {
+	for (int i=placements_length-1; i>=0; i--) {
+		Placement* p = placements[i];
+		if (p->buffer!=buffer || p->y<y1 || p->y>=y2)
+			continue;
+		p->y += amount;
+		if (p->y<top || p->y>=y2)
+			drop_placement_at(i, false);
+	}
+}
+
+// get the placements which cover row `y`, in the order they should be drawn (by z-index, then oldest first)
+// returns the number of items written to `out` (any past `max` are skipped)
+int placements_in_row(int buffer, int y, int max, Placement* out[max]) {
+	int n = 0;
+	FOR (i, placements_length) {
+		Placement* p = placements[i];
+		if (p->buffer!=buffer || y<p->y || y>=p->y+p->rows || n>=max)
+			continue;
+		// insertion sort
+		int j = n++;
+		for (; j>0 && (out[j-1]->z > p->z || out[j-1]->z==p->z && out[j-1]->serial > p->serial); j--)
+			out[j] = out[j-1];
+		out[j] = p;
+	}
+	return n;
+}
@@ -0,0 +1,46 @@
+#pragma once
+// Storage for images and their placements (see image.c)
+
+#include "common.h"
+
+typedef struct Image {
+	uint32_t id; // image id (kitty's `i=`)
+	uint32_t number; // image number (kitty's `I=`), 0 if none
+	int width, height;
+	uint32_t* pixels; // premultiplied ARGB (the format X Render uses), width*height
+	uint64_t used; // for LRU eviction (see image_touch())
+	uint64_t created;
+	bool temporary; // deleted along with its last placement (for sixel images, which can't be referred to again)
+} Image;
+
+// an image displayed on the cell grid
+// placements are anchored to rows, so they move along with the text when it scrolls
+typedef struct Placement {
+	Image* image;
+	uint32_t id; // placement id (kitty's `p=`), 0 if none
+	uint32_t serial; // unique. changes whenever the placement is modified (so the renderer can tell when to redraw)
+	int buffer; // 0 = main, 1 = alt
+	int x, y; // top left cell. y is a row index like get_row() uses (negative = in the scrollback)
+	int cols, rows; // area covered, in cells
+	int offset_x, offset_y; // pixel offset inside the top left cell
+	int src_x, src_y, src_w, src_h; // the part of the image that's shown
+	bool scaled; // whether to scale the image to fill the cells (otherwise, it's shown at its original size)
+	int z; // z-index: negative = below text
+} Placement;
+
+Image* image_create(uint32_t id, uint32_t number, int width, int height);
+Image* image_find(uint32_t id);
+Image* image_find_number(uint32_t number);
+uint32_t image_free_id(void);
+void image_touch(Image* image);
+void image_delete(Image* image);
+void image_delete_all(void);
+size_t image_memory_used(void);
+size_t image_quota(void);
+void image_cell_size(int* width, int* height);
+
+Placement* placement_create(Image* image, uint32_t id, int buffer);
+void placements_delete_where(bool (*match)(const Placement* p, const void* data), const void* data, bool free_images);
+void placements_clear(int buffer, int y1, int y2);
+void placements_shift(int buffer, int y1, int y2, int amount, int top);
+int placements_in_row(int buffer, int y, int max, Placement* out[max]);
@@ -2,6 +2,7 @@
 
 #include "keymap.h"
 #include "event.h"
+#include "paste.h"
 
 #include <X11/keysym.h>
 
@@ -158,6 +159,8 @@ KeyMap KEY_MAP[] = {
 	
 	// Ctrl+Shift+V -> paste clipboard
 	{XK_V, C|S, FUNCTION(clippaste)},
+	// Ctrl+Shift+Escape -> stop a paste that's still in progress
+	{XK_Escape, C|S, FUNCTION(paste_cancel)},
 	// copy text at cursor (limited, sorry for now)
 	//{XK_C, C|S, FUNCTION(simplecopy)},
 	
@@ -0,0 +1,521 @@
+// Kitty graphics protocol (https://sw.kovidgoyal.net/kitty/graphics-protocol/)
+// commands are APC strings: `ESC _ G <key>=<value>,... ; <payload> ESC \`
+// large images are sent in several chunks (m=1), and each chunk is decoded as soon as it arrives, so the base64 text is never stored
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <png.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "common.h"
+#include "kitty.h"
+#include "image.h"
+#include "vt.h"
+#include "buffer2.h"
+#include "base64.h"
+
+// the transmission that's currently being received
+PER_WINDOW static struct upload {
+	bool active; // waiting for more chunks
+	int args[128];
+	const utf8* error; // first error (sent in the response)
+	
+	Base64 base64; // (the payload can be split anywhere)
+	
+	bool zlib; // (o=z)
+	z_stream z;
+	bool z_done; // got the end of the compressed data
+	
+	// for the file/shared memory media, the payload is the name
+	bool has_name;
+	utf8 name[4096];
+	int name_length;
+	
+	// decoded data (in the transmitted format)
+	uint8_t* data;
+	size_t length, size;
+	size_t limit; // max length
+} up;
+
+static void fail(const utf8* error) {
+	if (!up.error)
+		up.error = error;
+}
+
+// parse the keys before the `;`. values are either numbers or single chars
+static bool parse_keys(int len, const utf8 s[len], int args[128]) {
+	int i = 0;
+	while (i<len) {
+		utf8 key = s[i++];
+		if (!(key>='a'&&key<='z' || key>='A'&&key<='Z')) {
+			print("invalid char in kitty seq\n");
+			return false;
+		}
+		if (i>=len || s[i]!='=') {
+			print("missing = after key name '%c' in kitty seq\n", key);
+			return false;
+		}
+		i++;
+		if (i<len && (s[i]=='-' || s[i]>='0'&&s[i]<='9')) {
+			bool negative = s[i]=='-';
+			if (negative)
+				i++;
+			uint32_t n = 0;
+			while (i<len && s[i]>='0' && s[i]<='9')
+				n = n*10 + s[i++]-'0';
+			args[key] = negative ? -(int)n : (int)n; // (ids are unsigned 32 bit, so this can wrap)
+		} else if (i<len) {
+			args[key] = s[i++];
+		}
+		if (i<len && s[i]!=',') {
+			print("invalid char after value in kitty seq\n");
+			return false;
+		}
+		i++;
+	}
+	return true;
+}
+
+static void respond(const int args[128], const utf8* error) {
+	uint32_t id = args['i'], number = args['I'];
+	if (!id && !number)
+		return; // (responses are only sent if an id was given)
+	if (args['q'] >= (error ? 2 : 1))
+		return;
+	utf8 buf[300];
+	int n = snprintf(buf, sizeof(buf), "\x1B_Gi=%u", id);
+	if (number)
+		n += snprintf(buf+n, sizeof(buf)-n, ",I=%u", number);
+	if (args['p'])
+		n += snprintf(buf+n, sizeof(buf)-n, ",p=%u", (uint32_t)args['p']);
+	vt_printf("%s;%s\x1B\\", buf, error ? error : "OK");
+}
+
+static void reset_upload(void) {
+	if (up.zlib && up.z.state)
+		inflateEnd(&up.z);
+	free(up.data);
+	up = (struct upload){0};
+}
+
+static bool reserve(size_t length) {
+	if (length > up.limit) {
+		fail("EFBIG:image data is too large");
+		return false;
+	}
+	if (length > up.size) {
+		size_t size = up.size ? up.size : 4096;
+		while (size < length)
+			size *= 2;
+		if (size > up.limit)
+			size = up.limit;
+		uint8_t* data = realloc(up.data, size);
+		if (!data) {
+			fail("ENOMEM:out of memory");
+			return false;
+		}
+		up.data = data;
+		up.size = size;
+	}
+	return true;
+}
+
+// decoded payload bytes
+static void add_data(size_t len, const uint8_t data[len]) {
+	if (up.error)
+		return;
+	if (up.has_name) {
+		if (up.name_length+len >= sizeof(up.name)) {
+			fail("EINVAL:file name too long");
+			return;
+		}
+		memcpy(up.name+up.name_length, data, len);
+		up.name_length += len;
+		return;
+	}
+	if (!up.zlib) {
+		if (reserve(up.length+len)) {
+			memcpy(up.data+up.length, data, len);
+			up.length += len;
+		}
+		return;
+	}
+	up.z.next_in = (uint8_t*)data;
+	up.z.avail_in = len;
+	while (up.z.avail_in && !up.z_done) {
+		if (up.length == up.size && up.size < up.limit && !reserve(up.length+1))
+			return;
+		// once the buffer is at the limit, the rest should just be the end of the stream
+		uint8_t extra;
+		bool full = up.length == up.size;
+		up.z.next_out = full ? &extra : up.data+up.length;
+		up.z.avail_out = full ? 1 : up.size-up.length;
+		int ret = inflate(&up.z, Z_NO_FLUSH);
+		if (!full)
+			up.length = up.size-up.z.avail_out;
+		else if (up.z.avail_out == 0) {
+			fail("EFBIG:image data is too large");
+			return;
+		}
+		if (ret == Z_STREAM_END)
+			up.z_done = true;
+		else if (ret != Z_OK) {
+			fail("EINVAL:invalid compressed data");
+			return;
+		}
+	}
+}
+
+void kitty_data(int len, const utf8 data[len]) {
+	if (!up.active || up.error)
+		return;
+	uint8_t out[BASE64_DECODED_SIZE(4096)];
+	for (int i=0; i<len; i+=4096) {
+		int n = len-i<4096 ? len-i : 4096;
+		add_data(base64_decode(&up.base64, n, data+i, out), out);
+		if (up.base64.error) {
+			fail("EINVAL:invalid base64 data");
+			return;
+		}
+	}
+}
+
+// open a file for reading, without blocking on fifos or opening devices (the name comes from whatever's printed to the terminal)
+// anything that isn't a regular file is rejected by the caller, after fstat()
+static Fd open_file(const utf8* name) {
+#ifdef O_PATH
+	// check what it is first, then open it for real through /proc (so it can't be swapped in between)
+	Fd path = open(name, O_PATH|O_CLOEXEC|O_NOFOLLOW);
+	if (path<0)
+		return -1;
+	struct stat st;
+	Fd fd = -1;
+	if (!fstat(path, &st) && S_ISREG(st.st_mode)) {
+		utf8 proc[40];
+		snprintf(proc, sizeof(proc), "/proc/self/fd/%d", path);
+		fd = open(proc, O_RDONLY|O_CLOEXEC|O_NONBLOCK|O_NOCTTY);
+	} else
+		errno = EINVAL;
+	close(path);
+	return fd;
+#else
+	return open(name, O_RDONLY|O_CLOEXEC|O_NOFOLLOW|O_NONBLOCK|O_NOCTTY);
+#endif
+}
+
+// read the image data from a file or shared memory object, for the t=f, t=t, and t=s media
+static void read_medium(void) {
+	int medium = up.args['t'];
+	utf8* name = up.name;
+	name[up.name_length] = '\0';
+	up.has_name = false;
+	
+	// (O_NONBLOCK: a fifo would block until someone opens it for writing)
+	Fd fd = medium=='s' ? shm_open(name, O_RDONLY|O_NONBLOCK, 0) : open_file(name);
+	if (fd<0) {
+		fail(errno==EINVAL ? "EBADF:not a regular file" : "EBADF:could not open file");
+		return;
+	}
+	struct stat st;
+	if (fstat(fd, &st) || !S_ISREG(st.st_mode)) {
+		fail("EBADF:not a regular file");
+		goto done;
+	}
+	size_t offset = up.args['O'];
+	size_t size = up.args['S'] ? (size_t)up.args['S'] : st.st_size>offset ? st.st_size-offset : 0;
+	if (offset+size > st.st_size) {
+		fail("ENODATA:file is too short");
+		goto done;
+	}
+	if (size) {
+		// (mmap needs a page aligned offset)
+		size_t skip = offset % sysconf(_SC_PAGESIZE);
+		uint8_t* map = mmap(NULL, size+skip, PROT_READ, MAP_PRIVATE, fd, offset-skip);
+		if (map == MAP_FAILED) {
+			fail("EBADF:could not read file");
+			goto done;
+		}
+		add_data(size, map+skip);
+		munmap(map, size+skip);
+	}
+ done:
+	close(fd);
+	// shared memory and temp files are deleted once they're read
+	if (medium=='s') {
+		shm_unlink(name);
+	} else if (medium=='t') {
+		const utf8* tmp = getenv("TMPDIR");
+		if (!tmp || !tmp[0])
+			tmp = "/tmp";
+		if (strstr(name, "tty-graphics-protocol") && !strncmp(name, tmp, strlen(tmp)) && !strstr(name, "/../"))
+			unlink(name);
+	}
+}
+
+static uint32_t premultiply(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+	r = (r*a+127)/255;
+	g = (g*a+127)/255;
+	b = (b*a+127)/255;
+	return (uint32_t)a<<24 | r<<16 | g<<8 | b;
+}
+
+// convert the received data into the image's format
+static void convert(Image* image, const uint8_t* rgba, int format) {
+	size_t count = (size_t)image->width*image->height;
+	if (format==24) {
+		for (size_t i=0; i<count; i++, rgba+=3)
+			image->pixels[i] = 0xFF000000 | rgba[0]<<16 | rgba[1]<<8 | rgba[2];
+	} else {
+		for (size_t i=0; i<count; i++, rgba+=4)
+			image->pixels[i] = premultiply(rgba[0], rgba[1], rgba[2], rgba[3]);
+	}
+}
+
+// decode the data, and store the image (unless this is just a query)
+static Image* finish_upload(void) {
+	int* args = up.args;
+	int format = args['f'];
+	if (up.zlib && !up.z_done)
+		fail("EINVAL:incomplete compressed data");
+	if (up.error)
+		return NULL;
+	
+	bool query = args['a']=='q';
+	uint32_t id = args['i'];
+	if (!id)
+		id = image_free_id();
+	
+	if (format==100) {
+		png_image png = {.version = PNG_IMAGE_VERSION};
+		if (!png_image_begin_read_from_memory(&png, up.data, up.length)) {
+			fail("EBADPNG:invalid png data");
+			return NULL;
+		}
+		png.format = PNG_FORMAT_RGBA;
+		Image* image = NULL;
+		uint8_t* rgba = NULL;
+		if (!query) {
+			image = image_create(id, args['I'], png.width, png.height);
+			if (!image)
+				fail("EFBIG:image is too large");
+		}
+		if (image || query) {
+			rgba = malloc(PNG_IMAGE_SIZE(png));
+			if (!rgba || !png_image_finish_read(&png, NULL, rgba, 0, NULL)) {
+				fail("EBADPNG:invalid png data");
+				if (image)
+					image_delete(image);
+				image = NULL;
+			} else if (image)
+				convert(image, rgba, 32);
+		}
+		png_image_free(&png);
+		free(rgba);
+		return image;
+	}
+	
+	if (up.length < up.limit) {
+		fail("ENODATA:insufficient image data");
+		return NULL;
+	}
+	if (query)
+		return NULL;
+	Image* image = image_create(id, args['I'], args['s'], args['v']);
+	if (!image) {
+		fail("EFBIG:image is too large");
+		return NULL;
+	}
+	convert(image, up.data, format);
+	return image;
+}
+
+// display an image at the cursor
+static void place(Image* image, const int args[128]) {
+	int cw, ch;
+	image_cell_size(&cw, &ch);
+	Placement* p = placement_create(image, args['p'], T.current==&T.buffers[1]);
+	p->x = limit(T.c.x, 0, T.width-1);
+	p->y = T.c.y;
+	p->z = args['z'];
+	// source rectangle
+	p->src_x = limit(args['x'], 0, image->width-1);
+	p->src_y = limit(args['y'], 0, image->height-1);
+	p->src_w = args['w']>0 ? limit(args['w'], 1, image->width-p->src_x) : image->width-p->src_x;
+	p->src_h = args['h']>0 ? limit(args['h'], 1, image->height-p->src_y) : image->height-p->src_y;
+	p->offset_x = limit(args['X'], 0, cw-1);
+	p->offset_y = limit(args['Y'], 0, ch-1);
+	// size in cells. if only one of c/r is given, the other is picked to keep the aspect ratio
+	int cols = args['c'], rows = args['r'];
+	p->scaled = cols>0 || rows>0;
+	if (cols>0 && rows<=0)
+		rows = ((int64_t)cols*cw*p->src_h/p->src_w + ch-1) / ch;
+	else if (rows>0 && cols<=0)
+		cols = ((int64_t)rows*ch*p->src_w/p->src_h + cw-1) / cw;
+	else if (!p->scaled) {
+		cols = (p->offset_x+p->src_w + cw-1) / cw;
+		rows = (p->offset_y+p->src_h + ch-1) / ch;
+	}
+	p->cols = limit(cols, 1, 1000);
+	p->rows = limit(rows, 1, 1000);
+	image_touch(image);
+	if (DEBUG.images)
+		print("placing image %u at %d,%d (%dx%d cells)\n", image->id, p->x, p->y, p->cols, p->rows);
+	
+	// move the cursor to the right of the image, on its last row
+	if (args['C']!=1) {
+		int x = p->x + p->cols;
+		forward_index(p->rows-1);
+		cursor_to(x, T.c.y);
+	}
+}
+
+static bool visible(const Placement* p) {
+	return p->buffer==(T.current==&T.buffers[1]) && p->y+p->rows>0 && p->y<T.height;
+}
+
+static bool match_delete(const Placement* p, const void* data) {
+	const int* args = data;
+	int what = args['d'] | 0x20; // (lowercase)
+	switch (what) {
+	case 'a': // all on screen
+		return visible(p);
+	case 'i': // by id (and placement id)
+		return p->image->id==(uint32_t)args['i'] && (!args['p'] || p->id==(uint32_t)args['p']);
+	case 'n': // by number
+		return p->image==image_find_number(args['I']) && (!args['p'] || p->id==(uint32_t)args['p']);
+	case 'c': // intersecting the cursor
+		return visible(p) && T.c.x>=p->x && T.c.x<p->x+p->cols && T.c.y>=p->y && T.c.y<p->y+p->rows;
+	case 'p': // intersecting a cell
+		return visible(p) && args['x']-1>=p->x && args['x']-1<p->x+p->cols && args['y']-1>=p->y && args['y']-1<p->y+p->rows;
+	case 'x': // intersecting a column
+		return visible(p) && args['x']-1>=p->x && args['x']-1<p->x+p->cols;
+	case 'y': // intersecting a row
+		return visible(p) && args['y']-1>=p->y && args['y']-1<p->y+p->rows;
+	case 'z': // by z-index
+		return visible(p) && p->z==args['z'];
+	}
+	return false;
+}
+
+static void start_upload(int args[128]) {
+	reset_upload();
+	memcpy(up.args, args, sizeof(up.args));
+	up.active = true;
+	
+	int format = args['f'];
+	int medium = args['t'];
+	if (args['i'] && args['I'])
+		fail("EINVAL:both i and I were specified");
+	if (format==24 || format==32) {
+		if (args['s']<=0 || args['v']<=0)
+			fail("EINVAL:missing image size");
+		// (reject it now, rather than buffering all the data first. same rule as image_create())
+		else if ((size_t)args['s']*args['v'] > image_quota()/sizeof(uint32_t))
+			fail("EFBIG:image is too large");
+		else
+			up.limit = (size_t)args['s']*args['v']*(format/8);
+	} else if (format==100) {
+		up.limit = image_quota();
+	} else {
+		fail("EINVAL:unsupported format");
+	}
+	if (medium!='d' && medium!='f' && medium!='t' && medium!='s')
+		fail("EINVAL:unsupported transmission medium");
+	if (args['o']=='z') {
+		up.zlib = true;
+		if (inflateInit(&up.z) != Z_OK)
+			fail("ENOMEM:zlib init failed");
+	}
+	up.has_name = medium != 'd';
+}
+
+void kitty_start(int len, const utf8 header[len]) {
+	int args[128] = {
+		['a'] = 't',
+		['f'] = 32,
+		['t'] = 'd',
+	};
+	if (!parse_keys(len, header, args)) {
+		if (up.active)
+			fail("EINVAL:invalid command");
+		return;
+	}
+	// the later chunks of a transmission only have the `m` key (and maybe `q`)
+	if (up.active) {
+		up.args['m'] = args['m'];
+		if (args['q'])
+			up.args['q'] = args['q'];
+		return;
+	}
+	switch (args['a']) {
+	case 't': // transmit
+	case 'T': // transmit and display
+	case 'q': // query (check if the image could be loaded, without storing it)
+		start_upload(args);
+		break;
+	case 'd':; // delete
+		// lowercase: delete placements. uppercase: also free the images if they have no placements left
+		int what = args['d'] ? args['d'] : 'a';
+		bool free_images = what>='A' && what<='Z';
+		if (!strchr("aicnpxyz", what|0x20)) {
+			if (DEBUG.images)
+				print("unsupported kitty delete: %c\n", what);
+			break;
+		}
+		args['d'] = what;
+		// (deleting by id/number with the uppercase key frees the image even if it isn't displayed)
+		if (what=='I' || what=='N') {
+			Image* image = what=='I' ? image_find(args['i']) : args['I'] ? image_find_number(args['I']) : NULL;
+			if (image && !args['p']) {
+				image_delete(image);
+				break;
+			}
+		}
+		if ((what|0x20)=='n' && !args['I'])
+			break;
+		placements_delete_where(match_delete, args, free_images);
+		break;
+	case 'p':; // display
+		Image* image = args['I'] ? image_find_number(args['I']) : image_find(args['i']);
+		if (!image) {
+			respond(args, "ENOENT:image not found");
+			break;
+		}
+		place(image, args);
+		respond(args, NULL);
+		break;
+	default:
+		print("unknown kitty graphics action: %c\n", args['a']);
+		respond(args, "EINVAL:unknown action");
+	}
+}
+
+void kitty_end(void) {
+	if (!up.active)
+		return;
+	if (up.args['m']==1)
+		return; // wait for the rest (if there was an error, the response is sent after the last chunk)
+	
+	if (!base64_end(&up.base64))
+		fail("EINVAL:invalid base64 data");
+	if (up.has_name && !up.error)
+		read_medium();
+	Image* image = finish_upload();
+	// (for I=, the response includes the id that was picked)
+	int args[128];
+	memcpy(args, up.args, sizeof(args));
+	if (image && !args['i'] && args['I'])
+		args['i'] = image->id;
+	if (image && args['a']=='T')
+		place(image, args);
+	if (DEBUG.images)
+		print("kitty transmission: %s\n", up.error ? up.error : "ok");
+	respond(args, up.error);
+	reset_upload();
+}
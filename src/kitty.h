@@ -0,0 +1,9 @@
+#pragma once
+// Kitty graphics protocol (see kitty.c)
+
+#include "common.h"
+
+// called for each APC string starting with `G`: first with the keys (before the `;`), then with the payload (possibly in several pieces), then kitty_end()
+void kitty_start(int len, const utf8 header[len]);
+void kitty_data(int len, const utf8 data[len]);
+void kitty_end(void);
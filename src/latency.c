@@ -0,0 +1,139 @@
+// Keypress-to-paint latency tracing (DEBUG_12TERM=latency)
+// a keypress is followed through each stage: the key event, the tty_write() it causes, the first read from the pty after that (hopefully the echo), the draw() after that, and the first row being copied to the window in that draw.
+// the time between each stage is collected into histograms, which are printed on exit, or when we get SIGUSR1.
+// (note: the final XCopyArea is only queued; the X server still has to process it and the compositor has to show it)
+
+#define _POSIX_C_SOURCE 200112L
+#include <signal.h>
+
+#include "common.h"
+#include "latency.h"
+#include "loop.h"
+
+enum stage {
+	IDLE,
+	KEY, // key pressed
+	WRITE, // written to tty
+	READ, // got output from tty
+	DRAW, // started drawing
+	STAGES,
+};
+
+// buckets are log-linear: values (in microseconds) under 64 get their own bucket, and each power of 2 above that is split into 64 buckets. so, the error is under 2%
+#define SUB_BUCKETS 64
+#define BUCKETS (SUB_BUCKETS*28)
+
+typedef struct Histogram {
+	uint32_t buckets[BUCKETS];
+	uint32_t count;
+	Nanosec max;
+} Histogram;
+
+static const char* stage_names[] = {
+	"key -> write", "write -> read", "read -> draw", "draw -> paint", "key -> paint",
+};
+// one for each transition, plus the total
+static Histogram histograms[LEN(stage_names)];
+
+static struct {
+	enum stage stage;
+	Nanosec times[STAGES];
+} trace;
+
+static int bucket(Nanosec t) {
+	int64_t us = t/1000;
+	if (us < SUB_BUCKETS)
+		return us<0 ? 0 : us;
+	int shift = 0;
+	while (us >= SUB_BUCKETS*2) {
+		us >>= 1;
+		shift++;
+	}
+	int b = (shift+1)*SUB_BUCKETS + (us-SUB_BUCKETS);
+	return b < BUCKETS ? b : BUCKETS-1;
+}
+
+// lowest value in a bucket (in microseconds)
+static int64_t bucket_value(int b) {
+	if (b < SUB_BUCKETS)
+		return b;
+	int shift = b/SUB_BUCKETS - 1;
+	return (int64_t)(SUB_BUCKETS + b%SUB_BUCKETS) << shift;
+}
+
+static void add(Histogram* h, Nanosec t) {
+	h->buckets[bucket(t)]++;
+	h->count++;
+	if (t > h->max)
+		h->max = t;
+}
+
+static double percentile(Histogram* h, double p) {
+	uint32_t target = h->count*p;
+	uint32_t seen = 0;
+	FOR (i, BUCKETS) {
+		seen += h->buckets[i];
+		if (seen > target)
+			return bucket_value(i)/1000.0;
+	}
+	return h->max/1000.0/1000.0;
+}
+
+static void on_sigusr1(int signum) {
+	latency_dump();
+}
+
+void latency_init(void) {
+	if (DEBUG.latency)
+		loop_signal(SIGUSR1, on_sigusr1);
+}
+
+static void reach(enum stage from, enum stage to) {
+	if (!DEBUG.latency || trace.stage != from)
+		return;
+	trace.stage = to;
+	trace.times[to] = loop_now();
+}
+
+void latency_key(void) {
+	if (!DEBUG.latency)
+		return;
+	// if the previous key didn't get any output yet, it probably never will, so start over with this one
+	if (trace.stage < READ)
+		trace.stage = IDLE;
+	reach(IDLE, KEY);
+}
+
+void latency_write(void) {
+	reach(KEY, WRITE);
+}
+
+void latency_read(void) {
+	reach(WRITE, READ);
+}
+
+void latency_draw(void) {
+	reach(READ, DRAW);
+}
+
+void latency_paint(void) {
+	if (!DEBUG.latency || trace.stage != DRAW)
+		return;
+	Nanosec now = loop_now();
+	for (int s=KEY; s<DRAW; s++)
+		add(&histograms[s-KEY], trace.times[s+1]-trace.times[s]);
+	add(&histograms[DRAW-KEY], now-trace.times[DRAW]);
+	add(&histograms[DRAW-KEY+1], now-trace.times[KEY]);
+	trace.stage = IDLE;
+}
+
+void latency_dump(void) {
+	if (!DEBUG.latency)
+		return;
+	print("latency (ms)     %8s %8s %8s %8s\n", "count", "p50", "p99", "max");
+	FOR (i, LEN(histograms)) {
+		Histogram* h = &histograms[i];
+		if (h->count)
+			print("%-16s %8u %8.2f %8.2f %8.2f\n", stage_names[i], h->count, percentile(h, 0.5), percentile(h, 0.99), h->max/1000.0/1000.0);
+	}
+}
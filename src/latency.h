@@ -0,0 +1,12 @@
+#pragma once
+// Keypress-to-paint latency tracing
+
+#include "common.h"
+
+void latency_init(void);
+void latency_key(void);
+void latency_write(void);
+void latency_read(void);
+void latency_draw(void);
+void latency_paint(void);
+void latency_dump(void);
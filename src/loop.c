@@ -0,0 +1,288 @@
+// Main event loop: waiting on file descriptors, timers, and signals
+// on linux this uses epoll, with a timerfd for the timers and a signalfd for signals, so nothing has to be rebuilt on every iteration.
+// other systems get a plain poll() fallback
+
+#define _POSIX_C_SOURCE 200112L
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#if defined(__linux)
+ #include <sys/epoll.h>
+ #include <sys/timerfd.h>
+ #include <sys/signalfd.h>
+#else
+ #include <poll.h>
+#endif
+
+#include "common.h"
+#include "loop.h"
+
+typedef struct Watch {
+	Fd fd; // -1 = unused slot
+	int events;
+	LoopHandler handler;
+} Watch;
+
+// (each window has its own set of watches and timers. signals are shared)
+PER_WINDOW static Watch watches[16];
+
+PER_WINDOW static Timer* timers[8];
+PER_WINDOW static int timer_count = 0;
+
+static void (*signal_handlers[65])(int);
+
+Nanosec loop_now(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec*1000LL*1000*1000 + t.tv_nsec;
+}
+
+static Watch* find_watch(Fd fd) {
+	FOR (i, LEN(watches))
+		if (watches[i].fd == fd)
+			return &watches[i];
+	return NULL;
+}
+
+// earliest timer deadline, or -1
+static Nanosec next_deadline(void) {
+	Nanosec next = -1;
+	FOR (i, timer_count) {
+		Nanosec w = timers[i]->when;
+		if (w>=0 && (next<0 || w<next))
+			next = w;
+	}
+	return next;
+}
+
+static void run_timers(void) {
+	Nanosec now = loop_now();
+	FOR (i, timer_count) {
+		Timer* t = timers[i];
+		if (t->when>=0 && t->when<=now) {
+			t->when = -1;
+			if (t->func)
+				t->func();
+		}
+	}
+}
+
+static void dispatch(Fd fd, int events) {
+	Watch* w = find_watch(fd);
+	if (w && w->handler)
+		w->handler(fd, events & w->events);
+}
+
+#if defined(__linux)
+
+PER_WINDOW static Fd epoll_fd = -1;
+PER_WINDOW static Fd timer_fd = -1;
+static Fd signal_fd = -1;
+static sigset_t signal_mask;
+PER_WINDOW static Nanosec timer_armed = -1; // deadline the timerfd is currently set to
+
+static int epoll_events(int events) {
+	return (events & LOOP_READ ? EPOLLIN : 0) | (events & LOOP_WRITE ? EPOLLOUT : 0);
+}
+
+static void epoll_add(Fd fd, int events) {
+	struct epoll_event ev = {.events = events, .data.fd = fd};
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+		if (errno!=EEXIST || epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev) < 0)
+			die("epoll_ctl failed: %s\n", strerror(errno));
+	}
+}
+
+void loop_init(void) {
+	FOR (i, LEN(watches))
+		watches[i].fd = -1;
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (epoll_fd<0)
+		die("epoll_create failed: %s\n", strerror(errno));
+	timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (timer_fd<0)
+		die("timerfd_create failed: %s\n", strerror(errno));
+	epoll_add(timer_fd, EPOLLIN);
+	sigemptyset(&signal_mask);
+}
+
+// an fd which becomes readable when loop_wait() has something to do
+// (so one loop can be waited on from another one, see daemon.c)
+Fd loop_fd(void) {
+	return epoll_fd;
+}
+
+void loop_free(void) {
+	close(epoll_fd);
+	close(timer_fd);
+	epoll_fd = timer_fd = -1;
+}
+
+// (re)arm the timerfd for the earliest deadline
+static void update_timerfd(void) {
+	Nanosec next = next_deadline();
+	if (next == timer_armed)
+		return;
+	timer_armed = next;
+	struct itimerspec spec = {0}; // all 0 = disarm
+	if (next>=0) {
+		if (next==0)
+			next = 1; // (0 would disarm it)
+		spec.it_value = (struct timespec){
+			.tv_sec = next/(1000*1000*1000),
+			.tv_nsec = next%(1000*1000*1000),
+		};
+	}
+	timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &spec, NULL);
+}
+
+// set the timerfd for the current timers without waiting
+// (loop_wait() does this itself. this is for when something else is waiting on loop_fd())
+void loop_prepare(void) {
+	update_timerfd();
+}
+
+void loop_signal(int signum, void (*handler)(int)) {
+	signal_handlers[signum] = handler;
+	sigaddset(&signal_mask, signum);
+	// the signal must be blocked, otherwise it'll be delivered normally instead of through the signalfd
+	// (remember to unblock it in any child processes!)
+	sigprocmask(SIG_BLOCK, &signal_mask, NULL);
+	Fd fd = signalfd(signal_fd, &signal_mask, SFD_NONBLOCK | SFD_CLOEXEC);
+	if (fd<0)
+		die("signalfd failed: %s\n", strerror(errno));
+	if (signal_fd<0) {
+		signal_fd = fd;
+		epoll_add(signal_fd, EPOLLIN);
+	}
+}
+
+static void read_signals(void) {
+	struct signalfd_siginfo info;
+	while (read(signal_fd, &info, sizeof(info)) == sizeof(info)) {
+		int signum = info.ssi_signo;
+		if (signum>0 && signum<LEN(signal_handlers) && signal_handlers[signum])
+			signal_handlers[signum](signum);
+	}
+}
+
+void loop_wait(bool block) {
+	update_timerfd();
+	struct epoll_event events[LEN(watches)+2];
+	int n;
+	do {
+		n = epoll_wait(epoll_fd, events, LEN(events), block ? -1 : 0);
+	} while (n<0 && errno==EINTR);
+	if (n<0)
+		die("epoll_wait failed: %s\n", strerror(errno));
+	
+	FOR (i, n) {
+		Fd fd = events[i].data.fd;
+		if (fd==timer_fd) {
+			uint64_t expirations;
+			read(timer_fd, &expirations, sizeof(expirations));
+			timer_armed = -1;
+			run_timers();
+		} else if (fd==signal_fd) {
+			read_signals();
+		} else {
+			int e = events[i].events;
+			// treat errors/hangups as readable, so the handler can find out what happened when it tries to read
+			dispatch(fd, (e & (EPOLLIN|EPOLLERR|EPOLLHUP) ? LOOP_READ : 0) | (e & EPOLLOUT ? LOOP_WRITE : 0));
+		}
+	}
+}
+
+#else
+
+void loop_init(void) {
+	FOR (i, LEN(watches))
+		watches[i].fd = -1;
+}
+
+Fd loop_fd(void) {
+	return -1;
+}
+
+void loop_free(void) {
+}
+
+void loop_prepare(void) {
+}
+
+void loop_signal(int signum, void (*handler)(int)) {
+	signal_handlers[signum] = handler;
+	signal(signum, handler);
+}
+
+void loop_wait(bool block) {
+	struct pollfd pfds[LEN(watches)];
+	Watch* order[LEN(watches)];
+	int count = 0;
+	FOR (i, LEN(watches)) {
+		if (watches[i].fd>=0) {
+			order[count] = &watches[i];
+			pfds[count++] = (struct pollfd){
+				.fd = watches[i].fd,
+				.events = (watches[i].events & LOOP_READ ? POLLIN : 0) | (watches[i].events & LOOP_WRITE ? POLLOUT : 0),
+			};
+		}
+	}
+	int timeout = -1;
+	Nanosec next = next_deadline();
+	if (!block)
+		timeout = 0;
+	else if (next>=0) {
+		Nanosec wait = next - loop_now();
+		timeout = wait>0 ? (wait+999999)/1000000 : 0; // round up to the next ms
+	}
+	int n = poll(pfds, count, timeout);
+	if (n<0 && errno!=EINTR)
+		die("poll failed: %s\n", strerror(errno));
+	FOR (i, n>0 ? count : 0) {
+		int e = pfds[i].revents;
+		if (e)
+			dispatch(order[i]->fd, (e & (POLLIN|POLLERR|POLLHUP) ? LOOP_READ : 0) | (e & POLLOUT ? LOOP_WRITE : 0));
+	}
+	run_timers();
+}
+
+#endif
+
+// start watching `fd` (or change the events/handler, if it's already being watched)
+// `handler` may be NULL, if you only want the loop to wake up
+void loop_watch(Fd fd, int events, LoopHandler handler) {
+	Watch* w = find_watch(fd);
+	if (!w)
+		w = find_watch(-1);
+	if (!w)
+		die("too many file descriptors in event loop\n");
+	*w = (Watch){fd, events, handler};
+#if defined(__linux)
+	epoll_add(fd, epoll_events(events));
+#endif
+}
+
+void loop_unwatch(Fd fd) {
+	Watch* w = find_watch(fd);
+	if (!w)
+		return;
+	w->fd = -1;
+#if defined(__linux)
+	epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+#endif
+}
+
+// set a timer to go off at `when` (or pass -1 to cancel it)
+void loop_timer(Timer* t, Nanosec when) {
+	if (!t->added) {
+		if (timer_count >= LEN(timers))
+			die("too many timers in event loop\n");
+		timers[timer_count++] = t;
+		t->added = true;
+	}
+	t->when = when;
+}
@@ -0,0 +1,28 @@
+#pragma once
+// Main event loop: waiting on file descriptors, timers, and signals
+
+#include "common.h"
+
+enum {
+	LOOP_READ = 1,
+	LOOP_WRITE = 2,
+};
+
+typedef void (*LoopHandler)(Fd fd, int events);
+
+typedef struct Timer {
+	Nanosec when; // deadline (see loop_now()), or -1 when not armed
+	void (*func)(void); // called when the timer expires (may be NULL, if you just want the loop to wake up)
+	bool added;
+} Timer;
+
+void loop_init(void);
+Fd loop_fd(void);
+void loop_free(void);
+void loop_watch(Fd fd, int events, LoopHandler handler);
+void loop_unwatch(Fd fd);
+void loop_timer(Timer* t, Nanosec when);
+void loop_signal(int signum, void (*handler)(int));
+void loop_wait(bool block);
+void loop_prepare(void);
+Nanosec loop_now(void);
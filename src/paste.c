@@ -0,0 +1,125 @@
+// Pasting text into the terminal
+// pastes are streamed: the source (i.e. the X selection) is asked for more data only when there's room in the queue,
+// and the queue is passed to the child only as fast as it reads it, so even huge pastes don't freeze the window
+
+#include <string.h>
+#include <assert.h>
+
+#include "common.h"
+#include "paste.h"
+#include "ring.h"
+#include "tty.h"
+#include "buffer.h"
+
+#define PASTE_QUEUE (256<<10)
+
+PER_WINDOW static struct paste {
+	bool active;
+	bool finished; // the source has no more data
+	bool bracketed; // whether bracketed paste mode was on when the paste started
+	size_t received; // total bytes from the source (including discarded ones)
+	PasteSource source;
+	PasteStop stop;
+	Ring queue; // translated data, waiting to be sent to the child
+} paste;
+
+// start a new paste. `source` will be called to request data, and `stop` is called if the paste is cancelled
+// returns false if a paste is already in progress
+bool paste_begin(PasteSource source, PasteStop stop) {
+	if (paste.active) {
+		print("a paste is already in progress\n");
+		return false;
+	}
+	if (!paste.queue.data)
+		ring_init(&paste.queue, PASTE_QUEUE, false);
+	paste.active = true;
+	paste.finished = false;
+	paste.received = 0;
+	paste.source = source;
+	paste.stop = stop;
+	paste.bracketed = T.bracketed_paste;
+	if (paste.bracketed)
+		tty_write(6, "\x1B[200~");
+	return true;
+}
+
+// add data to the queue (the source should never give more than `room` bytes)
+void paste_push(size_t len, const utf8 data[len]) {
+	paste.received += len;
+	if (!paste.active)
+		return;
+	// the queue doesn't grow, so anything past `room` is dropped
+	assert(len <= ring_space(&paste.queue));
+	if (len > ring_space(&paste.queue)) {
+		print("paste source sent too much data, dropping %zu bytes\n", len-ring_space(&paste.queue));
+		len = ring_space(&paste.queue);
+	}
+	while (len > 0) {
+		size_t n;
+		utf8* span = ring_write_span(&paste.queue, &n);
+		if (n > len)
+			n = len;
+		memcpy(span, data, n);
+		// replace \n with \r
+		utf8* repl = span;
+		while ((repl = memchr(repl, '\n', span+n-repl)))
+			*repl++ = '\r';
+		ring_produce(&paste.queue, n);
+		data += n;
+		len -= n;
+	}
+}
+
+// called by the source when all the data has been sent
+void paste_end(void) {
+	paste.finished = true;
+}
+
+// stop the current paste, and tell the source to stop sending data
+// (this works even if the source has stalled, so a new paste can be started right away)
+void paste_cancel(void) {
+	if (!paste.active)
+		return;
+	print("paste cancelled\n");
+	if (!paste.finished)
+		paste.stop();
+	ring_consume(&paste.queue, ring_length(&paste.queue));
+	if (paste.bracketed)
+		tty_write(6, "\x1B[201~");
+	paste.active = false;
+}
+
+void paste_free(void) {
+	ring_free(&paste.queue);
+	paste.active = false;
+}
+
+// call this from the main loop: move data along from the source to the child
+void paste_pump(void) {
+	if (!paste.active)
+		return;
+	bool progress = true;
+	while (progress) {
+		progress = false;
+		// request more data
+		size_t room = ring_space(&paste.queue);
+		if (!paste.finished && room > 0) {
+			size_t before = paste.received;
+			paste.source(room);
+			progress = paste.received!=before || paste.finished;
+		}
+		// send it
+		size_t len;
+		utf8* span;
+		while (!tty_write_busy() && (span = ring_read_span(&paste.queue, &len))) {
+			tty_write(len, span);
+			ring_consume(&paste.queue, len);
+			progress = true;
+		}
+	}
+	if (paste.finished && !ring_length(&paste.queue)) {
+		if (paste.bracketed)
+			tty_write(6, "\x1B[201~");
+		paste.active = false;
+	}
+}
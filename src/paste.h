@@ -0,0 +1,15 @@
+#pragma once
+
+#include "common.h"
+
+// called when there is room in the paste queue for (at most) `room` more bytes
+typedef void (*PasteSource)(size_t room);
+// called when the paste is cancelled before the source is finished
+typedef void (*PasteStop)(void);
+
+bool paste_begin(PasteSource source, PasteStop stop);
+void paste_push(size_t len, const utf8 data[len]);
+void paste_end(void);
+void paste_cancel(void);
+void paste_pump(void);
+void paste_free(void);
@@ -0,0 +1,156 @@
+// Session recording
+// when enabled, everything read from the pty (plus resizes) is saved to a file, so sessions can be replayed later (see RECORD_12TERM in record.h)
+// the file is written by a separate thread, so a slow disk never holds up reading.
+// records are appended to the `front` buffer. the writer thread swaps it with `back` and writes that out, while we fill the new front.
+
+#define _POSIX_C_SOURCE 200112L
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "common.h"
+#include "record.h"
+#include "settings.h"
+#include "loop.h"
+
+typedef struct RecordBuffer {
+	utf8* data;
+	size_t length, size;
+} RecordBuffer;
+
+// the writer is woken up when this much data is waiting
+#define RECORD_FLUSH (256<<10)
+// max size of the front buffer, if the writer can't keep up (past this, data is dropped)
+#define RECORD_MAX (64<<20)
+
+static bool recording = false;
+static FILE* file;
+static Nanosec start_time;
+
+static pthread_t writer;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake = PTHREAD_COND_INITIALIZER;
+static RecordBuffer buffers[2];
+static RecordBuffer* front = &buffers[0];
+static bool quit = false;
+static size_t dropped = 0;
+
+static void* writer_main(void* arg) {
+	pthread_mutex_lock(&lock);
+	while (1) {
+		// wait until there's a decent amount of data, but write at least once per second, so not much is lost if we crash
+		struct timespec timeout;
+		clock_gettime(CLOCK_REALTIME, &timeout);
+		timeout.tv_sec += 1;
+		while (front->length < RECORD_FLUSH && !quit)
+			if (pthread_cond_timedwait(&wake, &lock, &timeout)==ETIMEDOUT)
+				break;
+		if (!front->length) {
+			if (quit)
+				break;
+			continue;
+		}
+		// swap, then write the old front buffer without holding the lock
+		RecordBuffer* back = front;
+		front = front==&buffers[0] ? &buffers[1] : &buffers[0];
+		pthread_mutex_unlock(&lock);
+		if (fwrite(back->data, 1, back->length, file) != back->length || fflush(file))
+			print("error writing recording: %s\n", strerror(errno));
+		back->length = 0;
+		pthread_mutex_lock(&lock);
+	}
+	pthread_mutex_unlock(&lock);
+	return NULL;
+}
+
+// the file name comes from the RECORD_12TERM env var, or the `recordFile` setting
+void record_init(void) {
+	utf8* path = getenv("RECORD_12TERM");
+	if (!path || !path[0])
+		path = settings.recordFile;
+	if (!path || !path[0])
+		return;
+	file = fopen(path, "wb");
+	if (!file) {
+		print("couldn't open recording file '%s': %s\n", path, strerror(errno));
+		return;
+	}
+	fwrite(RECORD_MAGIC, 1, sizeof(RECORD_MAGIC)-1, file);
+	FOR (i, 2) {
+		buffers[i].size = RECORD_FLUSH*2;
+		ALLOC(buffers[i].data, buffers[i].size);
+		if (!buffers[i].data)
+			die("recording buffer allocation failed\n");
+	}
+	start_time = loop_now();
+	// (signals should be handled on the main thread)
+	sigset_t all, old;
+	sigfillset(&all);
+	pthread_sigmask(SIG_SETMASK, &all, &old);
+	int err = pthread_create(&writer, NULL, writer_main, NULL);
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+	if (err)
+		die("failed to start recording thread: %s\n", strerror(err));
+	recording = true;
+	atexit(record_close);
+	print("recording to '%s'\n", path);
+}
+
+static void record(RecordType type, size_t len, const void* data) {
+	RecordHeader head = {
+		.time = loop_now() - start_time,
+		.length = len,
+		.type = type,
+	};
+	pthread_mutex_lock(&lock);
+	size_t need = front->length + sizeof(head) + len;
+	if (need > front->size) {
+		// the writer is behind. grow the buffer rather than waiting for it
+		size_t size = front->size;
+		while (size < need)
+			size *= 2;
+		if (size > RECORD_MAX) {
+			dropped += len;
+			goto unlock;
+		}
+		REALLOC(front->data, size);
+		if (!front->data)
+			die("recording buffer allocation failed\n");
+		front->size = size;
+	}
+	memcpy(front->data+front->length, &head, sizeof(head));
+	memcpy(front->data+front->length+sizeof(head), data, len);
+	front->length = need;
+	if (front->length >= RECORD_FLUSH)
+		pthread_cond_signal(&wake);
+ unlock:
+	pthread_mutex_unlock(&lock);
+}
+
+void record_output(size_t len, const utf8 data[len]) {
+	if (recording)
+		record(REC_OUTPUT, len, data);
+}
+
+void record_resize(int w, int h, Px pw, Px ph) {
+	if (recording)
+		record(REC_RESIZE, sizeof(RecordResize), &(RecordResize){w, h, pw, ph});
+}
+
+// write everything that's left, and close the file
+void record_close(void) {
+	if (!recording)
+		return;
+	recording = false;
+	pthread_mutex_lock(&lock);
+	quit = true;
+	pthread_cond_signal(&wake);
+	pthread_mutex_unlock(&lock);
+	pthread_join(writer, NULL);
+	if (dropped)
+		print("recording: dropped %zu bytes (disk too slow?)\n", dropped);
+	fclose(file);
+}
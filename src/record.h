@@ -0,0 +1,32 @@
+#pragma once
+// Session recording
+
+#include "common.h"
+
+// file format:
+// the file starts with RECORD_MAGIC (8 bytes), followed by records.
+// each record is a RecordHeader, followed by `length` bytes of data.
+// (all integers are in native byte order)
+#define RECORD_MAGIC "12TREC1\n"
+
+typedef struct RecordHeader {
+	int64_t time; // nanoseconds since recording started
+	uint32_t length;
+	uint8_t type; // RecordType
+	uint8_t pad[3];
+} RecordHeader;
+
+typedef enum RecordType {
+	REC_OUTPUT = 1, // data read from the pty
+	REC_RESIZE = 2, // data: RecordResize
+} RecordType;
+
+typedef struct RecordResize {
+	uint16_t width, height; // in cells
+	uint16_t pixel_width, pixel_height;
+} RecordResize;
+
+void record_init(void);
+void record_output(size_t len, const utf8 data[len]);
+void record_resize(int w, int h, Px pw, Px ph);
+void record_close(void);
@@ -0,0 +1,94 @@
+// Byte ring buffer
+// data is read and written in "spans": pointers into the buffer which can be passed directly to read()/write()/process_chars() etc., so nothing needs to be copied in or out
+
+#include <string.h>
+
+#include "common.h"
+#include "ring.h"
+
+static size_t round_pow2(size_t n) {
+	size_t p = 1;
+	while (p < n)
+		p <<= 1;
+	return p;
+}
+
+void ring_init(Ring* r, size_t size, bool shared) {
+	*r = (Ring){
+		.size = round_pow2(size),
+		.shared = shared,
+	};
+	ALLOC(r->data, r->size);
+	if (!r->data)
+		die("ring buffer allocation failed\n");
+}
+
+void ring_free(Ring* r) {
+	FREE(r->data);
+	*r = (Ring){0};
+}
+
+// make sure there are at least `n` bytes of free space, growing the buffer if necessary (up to `max` bytes total)
+// returns false if the space couldn't be made
+// this invalidates any spans you're holding
+bool ring_reserve(Ring* r, size_t n, size_t max) {
+	size_t len = ring_length(r);
+	if (r->size - len >= n)
+		return true;
+	if (r->shared)
+		return false;
+	size_t size = round_pow2(len+n);
+	if (size > max)
+		return false;
+	// copy the contents into the new buffer, unwrapped
+	utf8* data;
+	ALLOC(data, size);
+	if (!data)
+		return false;
+	size_t first;
+	utf8* span = ring_read_span(r, &first);
+	if (first) {
+		memcpy(data, span, first);
+		memcpy(data+first, r->data, len-first);
+	}
+	free(r->data);
+	r->data = data;
+	r->size = size;
+	r->tail = 0;
+	r->head = len;
+	return true;
+}
+
+// get the largest contiguous free region
+utf8* ring_write_span(Ring* r, size_t* len) {
+	size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+	size_t start = head & r->size-1;
+	size_t space = r->size - (head - atomic_load_explicit(&r->tail, memory_order_acquire));
+	*len = space < r->size-start ? space : r->size-start;
+	return r->data + start;
+}
+
+// mark `n` bytes (from the start of the write span) as written
+void ring_produce(Ring* r, size_t n) {
+	// release: the data must be visible before the consumer sees the new head
+	atomic_fetch_add_explicit(&r->head, n, memory_order_release);
+}
+
+// get the largest contiguous region of unread data
+// returns NULL if the buffer is empty
+utf8* ring_read_span(Ring* r, size_t* len) {
+	size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+	size_t start = tail & r->size-1;
+	size_t used = atomic_load_explicit(&r->head, memory_order_acquire) - tail;
+	*len = used < r->size-start ? used : r->size-start;
+	return used ? r->data + start : NULL;
+}
+
+// mark `n` bytes (from the start of the read span) as read
+void ring_consume(Ring* r, size_t n) {
+	// release: we must be done reading the data before the producer can overwrite it
+	size_t tail = atomic_fetch_add_explicit(&r->tail, n, memory_order_release) + n;
+	// when the buffer empties, move back to the start, so the next spans can be as long as possible
+	if (!r->shared && atomic_load_explicit(&r->head, memory_order_relaxed) == tail)
+		r->head = r->tail = 0;
+}
@@ -0,0 +1,36 @@
+#pragma once
+// Byte ring buffer
+
+#include <stdatomic.h>
+
+#include "common.h"
+
+// head and tail count the total number of bytes written/read, and are only wrapped (masked) when indexing.
+// so, head-tail is always the number of bytes stored, even when the buffer is completely full.
+
+// if `shared` is set, the ring can be used as a lock-free single-producer/single-consumer queue:
+// one thread may call the write functions (write_span/produce) while another calls the read functions (read_span/consume)
+// (the buffer can't grow or rewind in this mode, since that would move data out from under the other thread)
+typedef struct Ring {
+	utf8* data;
+	size_t size; // always a power of 2 (or 0 before init)
+	_Atomic size_t head; // write position (only modified by the producer)
+	_Atomic size_t tail; // read position (only modified by the consumer)
+	bool shared;
+} Ring;
+
+void ring_init(Ring* r, size_t size, bool shared);
+void ring_free(Ring* r);
+bool ring_reserve(Ring* r, size_t n, size_t max);
+utf8* ring_write_span(Ring* r, size_t* len);
+void ring_produce(Ring* r, size_t n);
+utf8* ring_read_span(Ring* r, size_t* len);
+void ring_consume(Ring* r, size_t n);
+
+static inline size_t ring_length(Ring* r) {
+	return atomic_load_explicit(&r->head, memory_order_acquire) - atomic_load_explicit(&r->tail, memory_order_acquire);
+}
+
+static inline size_t ring_space(Ring* r) {
+	return r->size - ring_length(r);
+}
@@ -0,0 +1,267 @@
+// Fast scanning of pty output
+// most of what programs print is plain ascii text, which the parser can skip through in big pieces instead of one byte at a time.
+// these use SSE2 (always available on x86-64), or AVX2/SSSE3 (checked at runtime), with a plain loop for everything else.
+
+#include "common.h"
+#include "scan.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+ #include <immintrin.h>
+ #define SCAN_X86 1
+#endif
+
+// printable ascii: 0x20-0x7E
+static bool printable(utf8 c) {
+	return (unsigned char)(c-0x20) < 0x5F;
+}
+
+#ifdef SCAN_X86
+// (compared as signed bytes, so anything >= 0x80 is negative, and fails the first check)
+
+static size_t scan_ascii_sse2(size_t len, const utf8 s[len]) {
+	const __m128i low = _mm_set1_epi8(0x1F), high = _mm_set1_epi8(0x7F);
+	size_t i = 0;
+	for (; i+16 <= len; i+=16) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(s+i));
+		__m128i ok = _mm_and_si128(_mm_cmpgt_epi8(v, low), _mm_cmplt_epi8(v, high));
+		unsigned mask = _mm_movemask_epi8(ok);
+		if (mask != 0xFFFF)
+			return i + __builtin_ctz(~mask);
+	}
+	while (i<len && printable(s[i]))
+		i++;
+	return i;
+}
+
+__attribute__((target("avx2")))
+static size_t scan_ascii_avx2(size_t len, const utf8 s[len]) {
+	const __m256i low = _mm256_set1_epi8(0x1F), high = _mm256_set1_epi8(0x7F);
+	size_t i = 0;
+	for (; i+32 <= len; i+=32) {
+		__m256i v = _mm256_loadu_si256((const __m256i*)(s+i));
+		__m256i ok = _mm256_and_si256(_mm256_cmpgt_epi8(v, low), _mm256_cmpgt_epi8(high, v));
+		unsigned mask = _mm256_movemask_epi8(ok);
+		if (mask != 0xFFFFFFFF)
+			return i + __builtin_ctz(~mask);
+	}
+	return i + scan_ascii_sse2(len-i, s+i);
+}
+#endif
+
+// returns the number of printable ascii chars at the start of `s`
+size_t scan_ascii(size_t len, const utf8 s[len]) {
+#ifdef SCAN_X86
+	// (most runs are short, so check the first few bytes before bothering with vectors)
+	if (len >= 16 && printable(s[0]) && printable(s[1])) {
+		static int avx2 = -1;
+		if (avx2 < 0)
+			avx2 = __builtin_cpu_supports("avx2");
+		return avx2 ? scan_ascii_avx2(len, s) : scan_ascii_sse2(len, s);
+	}
+#endif
+	size_t i = 0;
+	while (i<len && printable(s[i]))
+		i++;
+	return i;
+}
+
+// returns the number of bytes at the start of `s` which aren't C0 control chars (for reading the contents of control strings)
+size_t scan_string(size_t len, const utf8 s[len]) {
+	size_t i = 0;
+#ifdef SCAN_X86
+	const __m128i low = _mm_set1_epi8(0x20);
+	for (; i+16 <= len; i+=16) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(s+i));
+		unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(v, low), v));
+		if (mask != 0xFFFF)
+			return i + __builtin_ctz(~mask);
+	}
+#endif
+	while (i<len && (unsigned char)s[i] >= 0x20)
+		i++;
+	return i;
+}
+
+// UTF-8 decoding
+
+// decodes one character, if it's a complete, valid utf-8 sequence which isn't a control char.
+// returns the length of the sequence, or 0
+// (this is stricter than the parser's decoder: overlong forms, surrogates, etc. are left for it to deal with, so that invalid text is handled the same way no matter which one sees it)
+static int decode_one(size_t len, const utf8 s[len], Char* out) {
+	unsigned char c = s[0];
+	if (c < 0x80) {
+		if (c < 0x20)
+			return 0;
+		*out = c;
+		return 1;
+	}
+	int length;
+	Char ch;
+	unsigned char lo = 0x80, hi = 0xBF; // allowed range for the second byte
+	if (c>=0xC2 && c<=0xDF) {
+		length = 2;
+		ch = c & 0x1F;
+	} else if (c>=0xE0 && c<=0xEF) {
+		length = 3;
+		ch = c & 0x0F;
+		if (c==0xE0)
+			lo = 0xA0; // overlong
+		else if (c==0xED)
+			hi = 0x9F; // surrogates
+	} else if (c>=0xF0 && c<=0xF4) {
+		length = 4;
+		ch = c & 0x07;
+		if (c==0xF0)
+			lo = 0x90; // overlong
+		else if (c==0xF4)
+			hi = 0x8F; // > U+10FFFF
+	} else
+		return 0;
+	if (len < length)
+		return 0;
+	unsigned char c1 = s[1];
+	if (c1<lo || c1>hi)
+		return 0;
+	ch = ch<<6 | (c1 & 0x3F);
+	for (int i=2; i<length; i++) {
+		unsigned char cn = s[i];
+		if ((cn & 0xC0) != 0x80)
+			return 0;
+		ch = ch<<6 | (cn & 0x3F);
+	}
+	*out = ch;
+	return length;
+}
+
+#ifdef SCAN_X86
+// decodes 16 bytes at a time. each window starts at the beginning of a character, and ends before the last one if it's cut off.
+// the structure is checked using bitmasks: every continuation byte must be expected by a lead byte before it, and vice versa
+__attribute__((target("ssse3")))
+static size_t decode_utf8_ssse3(size_t len, const utf8 s[len], Char out[len], size_t* count) {
+	const __m128i zero = _mm_setzero_si128();
+	size_t i = 0, n = 0;
+	while (i+16 <= len) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(s+i));
+		unsigned high = _mm_movemask_epi8(v);
+		// control chars (< 0x20)
+		unsigned ctrl = ~_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(0x20)), v)) & 0xFFFF;
+		
+		// plain ascii
+		if (!(high|ctrl)) {
+			__m128i lo = _mm_unpacklo_epi8(v, zero), hi = _mm_unpackhi_epi8(v, zero);
+			_mm_storeu_si128((__m128i*)(out+n), _mm_unpacklo_epi16(lo, zero));
+			_mm_storeu_si128((__m128i*)(out+n+4), _mm_unpackhi_epi16(lo, zero));
+			_mm_storeu_si128((__m128i*)(out+n+8), _mm_unpacklo_epi16(hi, zero));
+			_mm_storeu_si128((__m128i*)(out+n+12), _mm_unpackhi_epi16(hi, zero));
+			i += 16;
+			n += 16;
+			continue;
+		}
+		
+		// classify bytes by their top bits
+		__m128i top = _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0F));
+		unsigned cont = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(v, _mm_set1_epi8((char)0xC0)), _mm_set1_epi8((char)0x80)));
+		unsigned lead2 = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(top, _mm_set1_epi8(0x0E)), _mm_set1_epi8(0x0C)));
+		unsigned lead3 = _mm_movemask_epi8(_mm_cmpeq_epi8(top, _mm_set1_epi8(0x0E)));
+		unsigned lead4 = _mm_movemask_epi8(_mm_cmpeq_epi8(top, _mm_set1_epi8(0x0F)));
+		unsigned expected = (lead2|lead3|lead4)<<1 | (lead3|lead4)<<2 | lead4<<3;
+		
+		// invalid lead bytes, and second bytes which make a sequence overlong, a surrogate, or > U+10FFFF
+		__m128i next = _mm_srli_si128(v, 1);
+		#define EQ(x, c) _mm_cmpeq_epi8(x, _mm_set1_epi8((char)(c)))
+		#define GE(x, c) _mm_cmpeq_epi8(_mm_max_epu8(x, _mm_set1_epi8((char)(c))), x)
+		__m128i bad = _mm_or_si128(_mm_or_si128(EQ(v, 0xC0), EQ(v, 0xC1)), GE(v, 0xF5));
+		bad = _mm_or_si128(bad, _mm_andnot_si128(GE(next, 0xA0), EQ(v, 0xE0)));
+		bad = _mm_or_si128(bad, _mm_and_si128(GE(next, 0xA0), EQ(v, 0xED)));
+		bad = _mm_or_si128(bad, _mm_andnot_si128(GE(next, 0x90), EQ(v, 0xF0)));
+		bad = _mm_or_si128(bad, _mm_and_si128(GE(next, 0x90), EQ(v, 0xF4)));
+		#undef EQ
+		#undef GE
+		
+		// stop at the first control char or error, or the end of the window,
+		// then back up to the start of the last character, if it's incomplete
+		int limit = __builtin_ctz(ctrl | 1<<16);
+		unsigned errors = ((cont^expected) | _mm_movemask_epi8(bad)) & ((1u<<limit)-1);
+		limit = __builtin_ctz(errors | 1u<<limit);
+		unsigned starts = ~cont & ~expected & ((2u<<limit)-1); // positions where a new character can start
+		int end = starts ? 31-__builtin_clz(starts) : 0;
+		if (!end)
+			break;
+		unsigned range = (1u<<end)-1;
+		
+		// all 3 byte sequences (cjk, box drawing, etc.)
+		if (end>=12 && (lead3 & 0xFFF)==0x249) {
+			// lane j = [byte 3j+2, byte 3j+1, byte 3j, 0]
+			__m128i x = _mm_shuffle_epi8(v, _mm_setr_epi8(2,1,0,-1, 5,4,3,-1, 8,7,6,-1, 11,10,9,-1));
+			x = _mm_or_si128(_mm_or_si128(
+				_mm_and_si128(x, _mm_set1_epi32(0x3F)),
+				_mm_and_si128(_mm_srli_epi32(x, 2), _mm_set1_epi32(0xFC0))),
+				_mm_and_si128(_mm_srli_epi32(x, 4), _mm_set1_epi32(0xF000)));
+			_mm_storeu_si128((__m128i*)(out+n), x);
+			i += 12;
+			n += 4;
+			continue;
+		}
+		// all 2 byte sequences (greek, cyrillic, etc.)
+		if (end==16 && lead2==0x5555) {
+			// lane j = [byte 2j+1, byte 2j, 0, 0]
+			__m128i a = _mm_shuffle_epi8(v, _mm_setr_epi8(1,0,-1,-1, 3,2,-1,-1, 5,4,-1,-1, 7,6,-1,-1));
+			__m128i b = _mm_shuffle_epi8(v, _mm_setr_epi8(9,8,-1,-1, 11,10,-1,-1, 13,12,-1,-1, 15,14,-1,-1));
+			a = _mm_or_si128(_mm_and_si128(a, _mm_set1_epi32(0x3F)), _mm_and_si128(_mm_srli_epi32(a, 2), _mm_set1_epi32(0x7C0)));
+			b = _mm_or_si128(_mm_and_si128(b, _mm_set1_epi32(0x3F)), _mm_and_si128(_mm_srli_epi32(b, 2), _mm_set1_epi32(0x7C0)));
+			_mm_storeu_si128((__m128i*)(out+n), a);
+			_mm_storeu_si128((__m128i*)(out+n+4), b);
+			i += 16;
+			n += 8;
+			continue;
+		}
+		// mixed: already validated, so just go through the lead bytes
+		const unsigned char* w = (const unsigned char*)s+i;
+		for (unsigned leads = ~cont & range; leads; leads &= leads-1) {
+			int p = __builtin_ctz(leads);
+			unsigned char c = w[p];
+			if (c < 0x80)
+				out[n++] = c;
+			else if (c < 0xE0)
+				out[n++] = (c&0x1F)<<6 | (w[p+1]&0x3F);
+			else if (c < 0xF0)
+				out[n++] = (c&0x0F)<<12 | (w[p+1]&0x3F)<<6 | (w[p+2]&0x3F);
+			else
+				out[n++] = (c&0x07)<<18 | (w[p+1]&0x3F)<<12 | (w[p+2]&0x3F)<<6 | (w[p+3]&0x3F);
+		}
+		i += end;
+	}
+	*count = n;
+	return i;
+}
+#endif
+
+// decodes printable text (anything other than C0 control chars) at the start of `s`, stopping before anything that isn't valid utf-8, or a character that's cut off at the end.
+// `out` must have room for `len` chars. returns the number of bytes used, and puts the number of chars into `count`
+size_t decode_utf8(size_t len, const utf8 s[len], Char out[len], size_t* count) {
+	size_t i = 0, n = 0;
+#ifdef SCAN_X86
+	static int ssse3 = -1;
+	if (ssse3 < 0)
+		ssse3 = __builtin_cpu_supports("ssse3");
+#endif
+	while (i < len) {
+#ifdef SCAN_X86
+		if (ssse3 && len-i >= 16) {
+			size_t k;
+			i += decode_utf8_ssse3(len-i, s+i, out+n, &k);
+			n += k;
+			if (i >= len)
+				break;
+		}
+#endif
+		// (the vector loop stops at anything unusual, so handle one char here then try again)
+		int l = decode_one(len-i, s+i, &out[n]);
+		if (!l)
+			break;
+		i += l;
+		n++;
+	}
+	*count = n;
+	return i;
+}
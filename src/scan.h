@@ -0,0 +1,8 @@
+#pragma once
+// Fast scanning of pty output (see scan.c)
+
+#include "common.h"
+
+size_t scan_ascii(size_t len, const utf8 s[len]);
+size_t scan_string(size_t len, const utf8 s[len]);
+size_t decode_utf8(size_t len, const utf8 s[len], Char out[len], size_t* count);
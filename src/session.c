@@ -0,0 +1,406 @@
+// Detachable sessions (SESSION_12TERM=name)
+// the pty, and a copy of the terminal state, are kept by a background "session server" process, which outlives the window.
+// when a window attaches, the server sends it a snapshot of the screen and history (see term_save()), and after that, it just forwards everything the child outputs. the window parses that as usual, so both copies of the state stay in sync.
+// keypresses (and resizes) from the window are sent back to the server as messages (see SessionHeader).
+// closing the window only detaches it: the shell keeps running, and the next window to attach to the same session picks up where it left off.
+// (only one window can be attached at a time. a new one replaces the old one)
+
+#define _GNU_SOURCE
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+#include <dirent.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "common.h"
+#include "session.h"
+#include "buffer.h"
+#include "ctlseqs.h"
+#include "tty.h"
+#include "loop.h"
+#include "vt.h"
+#include "daemon.h"
+
+#define SESSION_MAGIC "12TSESS1"
+
+// sent before the snapshot
+typedef struct SessionHello {
+	utf8 magic[8];
+	// these have to match, since the snapshot contains raw structs
+	uint32_t term_size, cell_size;
+	uint64_t length; // of the snapshot
+} SessionHello;
+
+// if the window doesn't read its output for this long, it's detached
+#define SEND_TIMEOUT 5
+
+static struct sockaddr_un address;
+PER_WINDOW static utf8* title = NULL;
+
+// (in the same private directory as the daemon socket, see runtime_socket())
+static struct sockaddr_un session_address(const utf8* name) {
+	utf8 file[100];
+	snprintf(file, sizeof(file), "session-%s", name);
+	for (utf8* c=file; *c; c++)
+		if (*c=='/')
+			*c = '_';
+	struct sockaddr_un addr;
+	if (!runtime_socket(&addr, file))
+		die("no usable directory for the session socket\n");
+	return addr;
+}
+
+static bool send_all(Fd fd, size_t len, const void* data) {
+	const utf8* p = data;
+	while (len) {
+		ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+		if (n<0) {
+			if (errno==EINTR)
+				continue;
+			return false;
+		}
+		p += n;
+		len -= n;
+	}
+	return true;
+}
+
+// == server ==
+
+static Fd listen_fd = -1;
+static Fd client_fd = -1; // the attached window
+
+// messages received from the window
+static utf8* inbox;
+static size_t inbox_length = 0, inbox_size = 0;
+#define INBOX_MAX (64<<20)
+
+static void detach(void) {
+	if (client_fd<0)
+		return;
+	print("window detached\n");
+	loop_unwatch(client_fd);
+	close(client_fd);
+	client_fd = -1;
+	inbox_length = 0;
+}
+
+// forward pty output to the window
+// (this is called by the tty code, right before the data is parsed)
+void session_output(size_t len, const utf8 data[len]) {
+	if (client_fd>=0 && !send_all(client_fd, len, data))
+		detach();
+}
+
+// snapshots are written in two passes: first just to measure the size, then for real
+static bool measuring;
+static uint64_t snapshot_length;
+static utf8 send_buffer[64<<10];
+static size_t send_length;
+static bool send_failed;
+
+static void send_flush(void) {
+	if (!send_failed && send_length && !send_all(client_fd, send_length, send_buffer))
+		send_failed = true;
+	send_length = 0;
+}
+
+static void snapshot_write(size_t len, const void* data) {
+	if (measuring) {
+		snapshot_length += len;
+		return;
+	}
+	if (len > sizeof(send_buffer)-send_length) {
+		send_flush();
+		if (len > sizeof(send_buffer)) {
+			if (!send_failed && !send_all(client_fd, len, data))
+				send_failed = true;
+			return;
+		}
+	}
+	memcpy(send_buffer+send_length, data, len);
+	send_length += len;
+}
+
+static void save_all(void) {
+	uint32_t title_length = title ? strlen(title) : 0;
+	snapshot_write(sizeof(title_length), &title_length);
+	snapshot_write(title_length, title);
+	parser_save(snapshot_write);
+	term_save(snapshot_write);
+}
+
+static void on_message(SessionHeader h, utf8* data) {
+	switch (h.type) {
+	case SESSION_INPUT:
+		tty_write(h.length, data);
+		break;
+	case SESSION_RESIZE:;
+		SessionResize r;
+		if (h.length != sizeof(r))
+			break;
+		memcpy(&r, data, sizeof(r));
+		if (r.w>0 && r.h>0) {
+			// (this can be slightly out of sync with the window, if output arrives while the message is in flight. but our copy is only used for the next snapshot, so it doesn't matter much)
+			term_resize(r.w, r.h);
+			tty_resize(r.w, r.h, r.pw, r.ph);
+		}
+		break;
+	default:
+		print("unknown session message: %d\n", h.type);
+	}
+}
+
+static void on_client(Fd fd, int events) {
+	while (1) {
+		if (inbox_length == inbox_size) {
+			if (inbox_size >= INBOX_MAX) {
+				print("window sent too much data\n");
+				detach();
+				return;
+			}
+			inbox_size = inbox_size ? inbox_size*2 : 4096;
+			REALLOC(inbox, inbox_size);
+		}
+		ssize_t n = recv(client_fd, inbox+inbox_length, inbox_size-inbox_length, MSG_DONTWAIT);
+		if (n<0 && errno==EINTR)
+			continue;
+		if (n<0 && (errno==EAGAIN || errno==EWOULDBLOCK))
+			break;
+		if (n<=0) {
+			detach();
+			return;
+		}
+		inbox_length += n;
+	}
+	size_t pos = 0;
+	SessionHeader h;
+	while (inbox_length-pos >= sizeof(h)) {
+		memcpy(&h, inbox+pos, sizeof(h));
+		if (inbox_length-pos-sizeof(h) < h.length)
+			break;
+		on_message(h, inbox+pos+sizeof(h));
+		pos += sizeof(h)+h.length;
+	}
+	memmove(inbox, inbox+pos, inbox_length-pos);
+	inbox_length -= pos;
+}
+
+static void on_connect(Fd fd, int events) {
+	Fd c = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+	if (c<0)
+		return;
+	if (!socket_peer_ok(c)) {
+		print("rejecting window from another user\n");
+		close(c);
+		return;
+	}
+	if (client_fd>=0) {
+		print("another window is attaching. detaching the old one\n");
+		detach();
+	}
+	client_fd = c;
+	print("window attached\n");
+	// (reads are non-blocking, but sends block, so a slow window slows down the child, just like a normal pty would)
+	setsockopt(client_fd, SOL_SOCKET, SO_SNDTIMEO, &(struct timeval){.tv_sec = SEND_TIMEOUT}, sizeof(struct timeval));
+	
+	Nanosec start = loop_now();
+	measuring = true;
+	snapshot_length = 0;
+	save_all();
+	measuring = false;
+	send_failed = false;
+	SessionHello hello = {
+		.magic = SESSION_MAGIC,
+		.term_size = sizeof(Term),
+		.cell_size = sizeof(Cell),
+		.length = snapshot_length,
+	};
+	snapshot_write(sizeof(hello), &hello);
+	save_all();
+	send_flush();
+	if (send_failed) {
+		detach();
+		return;
+	}
+	print("sent snapshot: %llu bytes in %.2f ms\n", (unsigned long long)snapshot_length, (loop_now()-start)/1000/1000.0);
+	loop_watch(client_fd, LOOP_READ, on_client);
+}
+
+// responses to queries are normally sent by the window, since it's parsing the same data. but if there isn't one, we have to do it
+static void server_reply(size_t len, const utf8 data[len]) {
+	if (client_fd<0)
+		tty_write(len, data);
+}
+
+static void server_title(utf8* s) {
+	free(title);
+	title = s ? strdup(s) : NULL;
+}
+
+static void server_close(void) {
+	print("session ended\n");
+	unlink(address.sun_path);
+	_exit(0);
+}
+
+// close every fd we inherited, except stdin/stdout/stderr and `keep`
+// (when started from the daemon, that's every window's pty, socket, epoll fd, etc. if we kept those, closing another window wouldn't hang up its shell, for example)
+static void close_other_fds(Fd keep) {
+	DIR* dir = opendir("/proc/self/fd");
+	if (!dir) {
+		for (Fd fd=3; fd<sysconf(_SC_OPEN_MAX); fd++)
+			if (fd!=keep)
+				close(fd);
+		return;
+	}
+	struct dirent* ent;
+	while ((ent = readdir(dir))) {
+		Fd fd = atoi(ent->d_name);
+		if (fd>2 && fd!=keep && fd!=dirfd(dir))
+			close(fd);
+	}
+	closedir(dir);
+}
+
+__attribute__((noreturn)) static void server_main(Fd x_fd) {
+	// (the connection belongs to the window that started us)
+	close(x_fd);
+	close_other_fds(listen_fd);
+	setsid();
+	// (stderr is kept, for debug messages)
+	Fd null = open("/dev/null", O_RDWR);
+	if (null>=0) {
+		dup2(null, 0);
+		dup2(null, 1);
+		if (null>1)
+			close(null);
+	}
+	signal(SIGHUP, SIG_IGN);
+	// this is a separate process now, even if it came from the daemon
+	in_daemon = false;
+	signal(SIGCHLD, SIG_DFL);
+	
+	loop_init();
+	vt = (VtCallbacks){
+		.set_title = server_title,
+		.write = server_reply,
+	};
+	tty_init();
+	tty_on_close(server_close);
+	tty_watch(NULL);
+	loop_watch(listen_fd, LOOP_READ, on_connect);
+	while (1) {
+		loop_wait(true);
+		tty_flush();
+	}
+}
+
+static void start_server(Fd x_fd) {
+	listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (listen_fd<0)
+		die("socket failed: %s\n", strerror(errno));
+	// (the server is gone, if we get here)
+	unlink(address.sun_path);
+	if (bind(listen_fd, (struct sockaddr*)&address, sizeof(address))<0 || listen(listen_fd, 4)<0)
+		die("couldn't listen on %s: %s\n", address.sun_path, strerror(errno));
+	pid_t pid = fork();
+	if (pid<0)
+		die("fork failed: %s\n", strerror(errno));
+	if (pid==0)
+		server_main(x_fd);
+	close(listen_fd);
+	print("started session server (pid %d) at %s\n", pid, address.sun_path);
+}
+
+// == window ==
+
+static Fd try_connect(void) {
+	Fd fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd<0)
+		die("socket failed: %s\n", strerror(errno));
+	if (connect(fd, (struct sockaddr*)&address, sizeof(address))<0) {
+		close(fd);
+		return -1;
+	}
+	if (!socket_peer_ok(fd))
+		die("session socket %s belongs to another user!\n", address.sun_path);
+	return fd;
+}
+
+// the snapshot is read in large chunks, but never past its end (what comes after it is pty output, which is handled by tty.c)
+static Fd snapshot_fd;
+static uint64_t snapshot_left;
+static utf8 receive_buffer[64<<10];
+static size_t receive_pos, receive_length;
+
+static bool snapshot_read(size_t len, void* data) {
+	utf8* out = data;
+	while (len) {
+		if (receive_pos == receive_length) {
+			size_t want = snapshot_left < sizeof(receive_buffer) ? snapshot_left : sizeof(receive_buffer);
+			if (!want)
+				return false;
+			ssize_t n = read(snapshot_fd, receive_buffer, want);
+			if (n<0 && errno==EINTR)
+				continue;
+			if (n<=0)
+				return false;
+			snapshot_left -= n;
+			receive_pos = 0;
+			receive_length = n;
+		}
+		size_t take = receive_length-receive_pos < len ? receive_length-receive_pos : len;
+		memcpy(out, receive_buffer+receive_pos, take);
+		receive_pos += take;
+		out += take;
+		len -= take;
+	}
+	return true;
+}
+
+// connect to a session (starting it if it doesn't exist), and load its state into T
+// `x_fd` is closed in the server process
+// returns a socket to pass to tty_attach()
+Fd session_connect(const utf8* name, Fd x_fd) {
+	address = session_address(name);
+	Fd fd = try_connect();
+	if (fd<0) {
+		start_server(x_fd);
+		fd = try_connect();
+		if (fd<0)
+			die("couldn't connect to session server: %s\n", strerror(errno));
+	}
+	
+	Nanosec start = loop_now();
+	snapshot_fd = fd;
+	SessionHello hello;
+	snapshot_left = sizeof(hello);
+	if (!snapshot_read(sizeof(hello), &hello) || memcmp(hello.magic, SESSION_MAGIC, sizeof(hello.magic)))
+		die("couldn't attach to session %s\n", name);
+	if (hello.term_size != sizeof(Term) || hello.cell_size != sizeof(Cell))
+		die("session %s was started by a different version of 12term\n", name);
+	snapshot_left = hello.length;
+	uint32_t title_length;
+	bool ok = snapshot_read(sizeof(title_length), &title_length) && title_length < 1<<20;
+	if (ok && title_length) {
+		ALLOC(title, title_length+1);
+		ok = snapshot_read(title_length, title);
+		title[title_length] = '\0';
+	}
+	if (!ok || !parser_load(snapshot_read) || !term_load(snapshot_read) || snapshot_left || receive_pos!=receive_length)
+		die("invalid snapshot from session %s\n", name);
+	time_log("load session snapshot");
+	print("attached to session %s (%llu bytes, %.2f ms)\n", name, (unsigned long long)hello.length, (loop_now()-start)/1000/1000.0);
+	return fd;
+}
+
+// the title from the snapshot (NULL = default)
+utf8* session_title(void) {
+	return title;
+}
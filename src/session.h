@@ -0,0 +1,25 @@
+#pragma once
+// Detachable sessions (see session.c)
+
+#include "common.h"
+
+// messages from the window to the session server
+// (in the other direction, there's just a snapshot of the terminal state, followed by everything the child outputs)
+enum {
+	SESSION_INPUT = 1, // data to write to the pty
+	SESSION_RESIZE, // SessionResize
+};
+
+typedef struct SessionHeader {
+	uint32_t length; // of the data following the header
+	uint8_t type;
+	uint8_t pad[3];
+} SessionHeader;
+
+typedef struct SessionResize {
+	uint16_t w, h, pw, ph;
+} SessionResize;
+
+Fd session_connect(const utf8* name, Fd x_fd);
+utf8* session_title(void);
+void session_output(size_t len, const utf8 data[len]);
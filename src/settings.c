@@ -1,5 +1,5 @@
 // note: this is NOT a configuration file!
-// it just contains functions for loading settings, and their default values
+// it just contains functions for loading settings (the default values are in defaults.c)
 // see `xresources-example.ad` for more information
 
 #include <X11/Xresource.h>
@@ -27,40 +27,6 @@ bool parse_x_color(const utf8* c, RGBColor* out) {
 	return false;
 }
 
-Settings settings = {
-	.palette = {
-	  // dark colors
-		{  0,  0,  0}, // dark black
-		{170,  0,  0}, // dark red
-		{  0,170,  0}, // dark green
-		{170, 85,  0}, // dark yellow
-		{  0,  0,170}, // dark blue
-		{170,  0,170}, // dark magenta
-		{  0,170,170}, // dark cyan
-		{170,170,170}, // dark white
-		// light colors
-		{ 85, 85, 85}, // light black
-		{255, 85, 85}, // light red
-		{ 85,255, 85}, // light green
-		{255,255, 85}, // light yellow
-		{ 85, 85,255}, // light blue
-		{255, 85,255}, // light magenta
-		{ 85,255,255}, // light cyan
-		{255,255,255}, // light white
-	},
-	.cursorColor = {  0,192,  0},
-	.foreground = {255,255,255},
-	.background = {  0,  0,  0},
-	.cursorShape = 2,
-	.saveLines = 2000,
-	.width = 80,
-	.height = 24,
-	.faceName = "monospace",
-	.faceSize = 12,
-	.hyperlinkCommand = "xdg-open",
-	.termName = "xterm-12term",
-};
-
 XrmDatabase	db = NULL;
 
 static bool get_string(utf8* name, utf8** out) {
@@ -176,23 +142,7 @@ void load_settings(int* argc, utf8** argv) {
 		sprintf(buf, "12term.color%d", i);
 		get_color(buf, &settings.palette[i]);
 	}
-	// init the rest of the palette
-	int p = 16;
-	// 6x6x6 rgb cube
-	const int brightness[6] = {0, 95, 135, 175, 215, 255};
-	for (int i=0; i<6*6*6; i++) {
-		settings.palette[p++] = (RGBColor){
-			brightness[i/6/6 % 6],
-			brightness[i/6 % 6],
-			brightness[i % 6],
-		};
-	}
-	// fill the rest with grayscale
-	for (int i=0; i<256-16-6*6*6; i++) {
-		settings.palette[p++] = (RGBColor) {
-			8 + 10*i, 8 + 10*i, 8 + 10*i,
-		};
-	}
+	init_default_palette();
 	
 	// non-xterm
 	get_integer(FIELD(width));
@@ -201,6 +151,12 @@ void load_settings(int* argc, utf8** argv) {
 	if (settings.hyperlinkCommand[0]=='\0')
 		settings.hyperlinkCommand = NULL;
 	get_integer(FIELD(cursorShape));
+	get_boolean(FIELD(readerThread));
+	get_string(FIELD(recordFile));
+	get_integer(FIELD(oscLimit));
+	get_integer(FIELD(dcsLimit));
+	get_integer(FIELD(apcLimit));
+	get_integer(FIELD(imageMemory));
 	
 	// xft
 	settings.xft.antialias = true;
@@ -1,5 +1,5 @@
 #pragma once
-#include <fontconfig/fontconfig.h>
+#include "common.h"
 
 #include "buffer.h"
 
@@ -18,6 +18,13 @@ typedef struct Settings {
 	utf8* hyperlinkCommand;
 	utf8* termName;
 	int saveLines;
+	bool readerThread;
+	utf8* recordFile;
+	// max length of OSC, DCS, and APC strings to keep in memory (see push_string() in ctlseqs.c)
+	int oscLimit;
+	int dcsLimit;
+	int apcLimit;
+	int imageMemory; // max memory used by images, in MB
 	
 	struct {
 		bool antialias;
@@ -35,8 +42,12 @@ typedef struct Settings {
 
 extern Settings settings;
 
+void init_default_palette(void);
+
 void load_settings(int* argc, utf8** argv);
 
+// (from fontconfig.h)
+typedef struct _FcPattern FcPattern;
 void pattern_default_substitute(FcPattern* pattern);
 
 // should this be in here?
@@ -0,0 +1,285 @@
+// Sixel graphics (DCS P1;P2;P3 q <data> ST)
+// the data is decoded as it arrives, so it's never stored as text.
+// pixels go into a bitmap of color register numbers (1 byte each), which is only converted to an image at the end.
+// (see https://vt100.net/docs/vt3xx-gp/chapter14.html)
+
+#include <string.h>
+
+#include "common.h"
+#include "sixel.h"
+#include "image.h"
+#include "settings.h"
+#include "vt.h"
+#include "buffer2.h"
+
+#define REGISTERS 255
+// largest width/height of an image (anything past this is clipped)
+#define MAX_SIZE 32767
+
+// the image that's being received
+PER_WINDOW static struct sixel {
+	bool active;
+	bool transparent; // (P2=1) pixels that aren't drawn are transparent, rather than the background color
+	uint32_t palette[REGISTERS]; // ARGB
+	int color; // current color register
+	
+	// bitmap: 0 = not drawn, otherwise color register+1
+	uint8_t* pixels;
+	int stride, rows; // allocated size
+	size_t limit; // max allocated size
+	int width, height; // area that's been drawn on (or set by the raster attributes)
+	int x, y; // position. y is the top of the current row of sixels
+	bool clipped;
+	
+	// command being parsed: 0, or one of `!"#`
+	utf8 command;
+	int params[5];
+	int param_count;
+	int repeat;
+} sx;
+
+// the VT340's default colors
+static const uint8_t default_palette[16][3] = {
+	{0,0,0}, {20,20,80}, {80,13,13}, {20,80,20}, {80,20,80}, {20,80,80}, {80,80,20}, {53,53,53},
+	{26,26,26}, {33,33,60}, {60,26,26}, {33,60,33}, {60,33,60}, {33,60,60}, {60,60,33}, {80,80,80},
+};
+
+static uint32_t rgb_percent(int r, int g, int b) {
+	r = limit(r, 0, 100)*255/100;
+	g = limit(g, 0, 100)*255/100;
+	b = limit(b, 0, 100)*255/100;
+	return 0xFF000000 | r<<16 | g<<8 | b;
+}
+
+// sixel hls has blue at 0°, red at 120°, green at 240°
+static uint32_t hls_color(int h, int l, int s) {
+	h = (h%360 + 360 + 240) % 360;
+	double lf = limit(l, 0, 100)/100.0, sf = limit(s, 0, 100)/100.0;
+	double c = (1-(lf>0.5 ? 2*lf-1 : 1-2*lf)) * sf;
+	double x = c * (1 - (h/60%2==0 ? 1-(h%60)/60.0 : (h%60)/60.0));
+	double m = lf-c/2;
+	double rgb[6][3] = {{c,x,0}, {x,c,0}, {0,c,x}, {0,x,c}, {x,0,c}, {c,0,x}};
+	double* v = rgb[h/60];
+	return rgb_percent((v[0]+m)*100+0.5, (v[1]+m)*100+0.5, (v[2]+m)*100+0.5);
+}
+
+static void reset(void) {
+	free(sx.pixels);
+	sx = (struct sixel){0};
+}
+
+// make room for `width`x`height` pixels. returns false if that would be too large
+static bool grow(int width, int height) {
+	if (width<=sx.stride && height<=sx.rows)
+		return true;
+	if (width>MAX_SIZE || height>MAX_SIZE)
+		return false;
+	// (grow by at least double, so this doesn't happen too often)
+	int stride = sx.stride, rows = sx.rows;
+	if (width > stride)
+		stride = width > stride*2 ? width : stride*2;
+	if (height > rows)
+		rows = height > rows*2 ? height : rows*2;
+	if (stride>MAX_SIZE)
+		stride = MAX_SIZE;
+	if (rows>MAX_SIZE)
+		rows = MAX_SIZE;
+	if ((size_t)stride*rows > sx.limit) {
+		// try the exact size
+		stride = width>sx.stride ? width : sx.stride;
+		rows = height>sx.rows ? height : sx.rows;
+		if ((size_t)stride*rows > sx.limit)
+			return false;
+	}
+	uint8_t* pixels = calloc((size_t)stride*rows, 1);
+	if (!pixels)
+		return false;
+	FOR (y, sx.rows)
+		memcpy(pixels+(size_t)y*stride, sx.pixels+(size_t)y*sx.stride, sx.stride);
+	free(sx.pixels);
+	sx.pixels = pixels;
+	sx.stride = stride;
+	sx.rows = rows;
+	return true;
+}
+
+// draw one sixel (a column of 6 pixels), `count` times
+static void put_sixel(int bits, int count) {
+	int x = sx.x;
+	// (stop moving right at the max width, so huge repeat counts can't overflow the position)
+	// (this used to crash on: ESC P q #1~ then `!999999~` 2200 times, then ESC \)
+	if (x<0 || x>=MAX_SIZE) {
+		sx.clipped = true;
+		return;
+	}
+	count = limit(count, 0, MAX_SIZE-x);
+	sx.x += count;
+	if (!grow(sx.x, sx.y+6)) {
+		if (!sx.clipped && DEBUG.images)
+			print("sixel image too large, clipping it\n");
+		sx.clipped = true;
+		// draw the part that fits
+		if (sx.y+6 > sx.rows || x >= sx.stride)
+			return;
+		count = limit(count, 0, sx.stride-x);
+	}
+	if (x+count > sx.width)
+		sx.width = x+count;
+	if (!bits)
+		return;
+	uint8_t* p = sx.pixels + (size_t)sx.y*sx.stride + x;
+	FOR (i, 6) {
+		if (bits>>i & 1) {
+			if (count==1)
+				*p = sx.color+1;
+			else
+				memset(p, sx.color+1, count);
+			if (sx.y+i+1 > sx.height)
+				sx.height = sx.y+i+1;
+		}
+		p += sx.stride;
+	}
+}
+
+// a command's parameters have ended
+static void finish_command(void) {
+	int* a = sx.params;
+	switch (sx.command) {
+	case '!': // repeat
+		sx.repeat = a[0];
+		break;
+	case '"': // raster attributes: aspect ratio (ignored), width, height
+		if (sx.param_count>=4 && grow(a[2], a[3])) {
+			if (a[2] > sx.width)
+				sx.width = a[2];
+			if (a[3] > sx.height)
+				sx.height = a[3];
+		}
+		break;
+	case '#': // select color, or define color
+		sx.color = a[0] % REGISTERS;
+		if (sx.param_count>=5) {
+			if (a[1]==1)
+				sx.palette[sx.color] = hls_color(a[2], a[3], a[4]);
+			else if (a[1]==2)
+				sx.palette[sx.color] = rgb_percent(a[2], a[3], a[4]);
+		}
+		break;
+	}
+	sx.command = 0;
+}
+
+void sixel_start(int argc, const int argv[argc]) {
+	reset();
+	sx.active = true;
+	sx.transparent = argc>1 && argv[1]==1;
+	sx.limit = (size_t)settings.imageMemory*1024*1024/sizeof(uint32_t); // (so the final image fits too)
+	FOR (i, REGISTERS) {
+		if (i<16) {
+			const uint8_t* c = default_palette[i];
+			sx.palette[i] = rgb_percent(c[0], c[1], c[2]);
+		} else {
+			RGBColor c = T.palette[i];
+			sx.palette[i] = 0xFF000000 | c.r<<16 | c.g<<8 | c.b;
+		}
+	}
+}
+
+void sixel_data(int len, const utf8 data[len]) {
+	if (!sx.active)
+		return;
+	FOR (i, len) {
+		unsigned char c = data[i];
+		if (c>='?' && c<='~' && !sx.command) { // sixel
+			put_sixel(c-'?', sx.repeat>0 ? sx.repeat : 1);
+			sx.repeat = 0;
+			continue;
+		}
+		if (sx.command) {
+			if (c>='0' && c<='9') {
+				int* p = &sx.params[sx.param_count-1];
+				if (*p < 100000)
+					*p = *p*10 + c-'0';
+				continue;
+			}
+			if (c==';') {
+				if (sx.param_count < LEN(sx.params))
+					sx.params[sx.param_count++] = 0;
+				continue;
+			}
+			finish_command();
+			if (c>='?' && c<='~') {
+				i--; // (now draw it)
+				continue;
+			}
+		}
+		switch (c) {
+		case '!': case '"': case '#':
+			sx.command = c;
+			sx.params[0] = 0;
+			sx.param_count = 1;
+			break;
+		case '$': // carriage return
+			sx.x = 0;
+			break;
+		case '-': // next line
+			sx.x = 0;
+			// (past the max height, everything is clipped anyway)
+			if (sx.y < MAX_SIZE)
+				sx.y += 6;
+			break;
+		}
+	}
+}
+
+// whether the placement `p` is a sixel image that's hidden under `data`
+static bool covered(const Placement* p, const void* data) {
+	const Placement* top = data;
+	return p!=top && p->image->temporary && p->buffer==top->buffer && p->z<=top->z && p->x>=top->x && p->y>=top->y && p->x+p->cols<=top->x+top->cols && p->y+p->rows<=top->y+top->rows;
+}
+
+// turn the bitmap into an image, and display it at the cursor
+void sixel_end(void) {
+	if (!sx.active)
+		return;
+	if (sx.command)
+		finish_command();
+	int width = sx.width<sx.stride ? sx.width : sx.stride;
+	int height = sx.height<sx.rows ? sx.height : sx.rows;
+	Image* image = width>0 && height>0 ? image_create(image_free_id(), 0, width, height) : NULL;
+	if (!image) {
+		reset();
+		return;
+	}
+	image->temporary = true;
+	uint32_t colors[REGISTERS+1];
+	colors[0] = sx.transparent ? 0 : 0xFF000000 | T.background.r<<16 | T.background.g<<8 | T.background.b;
+	memcpy(colors+1, sx.palette, sizeof(sx.palette));
+	bool opaque = !sx.transparent;
+	FOR (y, height) {
+		const uint8_t* src = sx.pixels + (size_t)y*sx.stride;
+		uint32_t* dest = image->pixels + (size_t)y*width;
+		FOR (x, width)
+			dest[x] = colors[src[x]];
+	}
+	reset();
+	
+	int cw, ch;
+	image_cell_size(&cw, &ch);
+	Placement* p = placement_create(image, 0, T.current==&T.buffers[1]);
+	p->x = limit(T.c.x, 0, T.width-1);
+	p->y = T.c.y;
+	p->src_w = width;
+	p->src_h = height;
+	p->cols = (width+cw-1) / cw;
+	p->rows = (height+ch-1) / ch;
+	if (DEBUG.images)
+		print("sixel image %dx%d at %d,%d\n", width, height, p->x, p->y);
+	// sixel images that are completely covered by this one are gone now
+	if (opaque)
+		placements_delete_where(covered, p, false);
+	
+	// move the cursor to the start of the line below the image
+	forward_index(p->rows);
+	carriage_return();
+}
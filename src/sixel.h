@@ -0,0 +1,9 @@
+#pragma once
+// Sixel graphics (see sixel.c)
+
+#include "common.h"
+
+// called for DCS strings with the final char `q`: first with the DCS parameters, then with the data (possibly in many pieces), then sixel_end()
+void sixel_start(int argc, const int argv[argc]);
+void sixel_data(int len, const utf8 data[len]);
+void sixel_end(void);
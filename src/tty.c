@@ -13,7 +13,6 @@
  #error unsupported system
 #endif
 
-#include <sys/select.h>
 #include <signal.h>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -24,20 +23,83 @@
 #include <pwd.h>
 #include <stdarg.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#if defined(__linux)
+ #include <sys/eventfd.h>
+#endif
 // more headers might be required here, not sure...
 
 #include "common.h"
 #include "tty.h"
 #include "ctlseqs.h"
 #include "settings.h"
+#include "ring.h"
+#include "loop.h"
+#include "record.h"
+#include "latency.h"
+#include "session.h"
+#include "daemon.h"
 
 // this is probably most likely always going to be "-c" but just in case..
 #define SHELL_EVAL_FLAG "-c"
 
-void sleep_forever(bool hangup); // nnn where do these decs go...
+void close_window(bool hangup); // nnn where do these decs go...
+
+PER_WINDOW static Fd master_fd;
+PER_WINDOW static pid_t child_pid;
+// when attached to a session (see session.c), master_fd is a socket connected to the session server, rather than the pty itself
+PER_WINDOW static bool attached = false;
+// called when the child exits, before close_window()
+PER_WINDOW static void (*on_close)(void);
+
+// data read from the pty, waiting to be parsed
+PER_WINDOW static Ring input;
+
+// the input buffer starts at this size, and grows when the child is writing faster than this
+#define READ_CHUNK 4096
+// max size of the input buffer
+#define READ_MAX (1<<20)
+// limits on how much to read per call to tty_read(), so we still get to handle x events and redraw while a program is flooding output
+#define READ_BUDGET (4<<20)
+// (this is adjusted by the frame scheduler, see tty_set_read_budget())
+PER_WINDOW static Nanosec read_time_budget = 5*1000*1000;
+// set when a read stopped because it ran out of budget, with more data still waiting
+PER_WINDOW static bool read_more = false;
+// data is parsed in pieces of at most this size, checking the budget (and for user input) in between
+#define PARSE_CHUNK (64<<10)
+// returns true if tty_read() should stop early (see tty_set_yield())
+PER_WINDOW static bool (*yield)(void);
 
-static Fd master_fd;
-static pid_t child_pid;
+static void on_pty_event(Fd fd, int events);
+// used to continue parsing data that's already been read, after tty_read() stops early
+static void resume_read(void);
+PER_WINDOW static Timer resume_timer = {.func = resume_read};
+
+// whether tty_read() should stop parsing now
+static bool read_done(Nanosec start, size_t total) {
+	return total >= READ_BUDGET || loop_now()-start >= read_time_budget || yield && yield();
+}
+
+PER_WINDOW static atomic_bool pty_closed = false;
+
+// data waiting to be written to the pty
+PER_WINDOW static Ring output;
+// tty_write_busy() returns true when more than this much data is queued
+#define WRITE_HIGH_WATER (64<<10)
+// max size of the output queue (past this, writes are dropped)
+#define WRITE_MAX (64<<20)
+
+PER_WINDOW static bool use_thread = false;
+static void start_reader(void);
+static void tty_setup(void);
+#ifdef USE_IO_URING
+static bool use_uring = false;
+static bool uring_start(void);
+#endif
 
 void sigchld(int signum) {
 	(void)signum;
@@ -89,6 +151,9 @@ static void execsh(void) {
 	signal(SIGQUIT, SIG_DFL);
 	signal(SIGTERM, SIG_DFL);
 	signal(SIGALRM, SIG_DFL);
+	sigset_t none;
+	sigemptyset(&none);
+	sigprocmask(SIG_SETMASK, &none, NULL);
 
 	char* eval = getenv("LAUNCH_12TERM");
 
@@ -120,26 +185,448 @@ void tty_init(void) {
 		_exit(0);
 	} else { // PARENT
 		openbsd_pledge("stdio rpath tty proc", NULL); 
-		fcntl(master_fd, F_SETFL, O_NONBLOCK);
-		signal(SIGCHLD, sigchld);
+		// (so other windows' shells don't inherit it, in daemon mode)
+		fcntl(master_fd, F_SETFD, FD_CLOEXEC);
+		// (the daemon ignores SIGCHLD, so children are reaped automatically. sigchld() only knows about one child)
+		if (!in_daemon)
+			loop_signal(SIGCHLD, sigchld);
+		tty_setup();
 	}
 }
 
-// read from child process and process the text
-size_t tty_read(void) {
-	char buf[4096]; // how big to make this?
-	ssize_t len = read(master_fd, buf, LEN(buf));
-	//print("read %ld bytes\n", len);
-	if (len>0) {
-		process_chars(len, buf);
-		return len;
-	} else if (len<0 && errno!=EAGAIN) {
-		print("couldn't read from shell. status: \"%s\"\n", strerror(errno));
-		// this is the normal exit condition.
-		sleep_forever(true);
+// use a connection to a session server instead of starting a child process
+void tty_attach(Fd fd) {
+	master_fd = fd;
+	attached = true;
+	tty_setup();
+}
+
+static void tty_setup(void) {
+	fcntl(master_fd, F_SETFL, O_NONBLOCK);
+	ring_init(&output, 4096, false);
+	// (the reader thread and io_uring aren't used in daemon mode, since their state can't be swapped out when switching windows)
+	use_thread = settings.readerThread && !in_daemon;
+	if (use_thread) {
+		ring_init(&input, READ_MAX, true);
+		start_reader();
+	} else
+		ring_init(&input, READ_CHUNK, false);
+#ifdef USE_IO_URING
+	if (!use_thread && !in_daemon)
+		use_uring = uring_start();
+#endif
+}
+
+static void closed(void) {
+	if (on_close)
+		on_close();
+	close_window(true);
+}
+
+PER_WINDOW static int read_calls = 0; // number of read()/ioctl() syscalls (for debug stats)
+
+// pass data from the pty to the parser
+static void parse(size_t len, const utf8 data[len]) {
+	record_output(len, data);
+	latency_read();
+	session_output(len, data);
+	process_chars(len, data);
+}
+
+// read from the pty into `input` until it's empty (or `budget` bytes have been read)
+// returns the number of bytes read, and sets `*drained` if the pty has no more data
+static size_t tty_fill(size_t budget, bool* drained) {
+	size_t total = 0;
+	*drained = false;
+	size_t want = READ_CHUNK;
+	while (total < budget) {
+		if (!ring_reserve(&input, want, READ_MAX) && ring_space(&input)==0)
+			break; // buffer is full
+		size_t len;
+		utf8* span = ring_write_span(&input, &len);
+		if (len > budget-total)
+			len = budget-total;
+		if (len==0)
+			break;
+		ssize_t got = read(master_fd, span, len);
+		read_calls++;
+		if (got<0) {
+			if (errno==EINTR)
+				continue;
+			if (errno==EAGAIN)
+				*drained = true;
+			else {
+				// this is the normal exit condition.
+				print("couldn't read from shell. status: \"%s\"\n", strerror(errno));
+				pty_closed = true;
+			}
+			break;
+		}
+		ring_produce(&input, got);
+		total += got;
+		if (got==0) {
+			// (the other end of a session socket was closed)
+			pty_closed = true;
+			break;
+		}
+		// ask how much is left, so we can grow the buffer to fit it all at once
+		// (note: a short read doesn't mean the pty is empty. the line discipline only hands over ~4K at a time)
+		int avail = 0;
+		read_calls++;
+		if (ioctl(master_fd, FIONREAD, &avail)==0) {
+			if (avail==0) {
+				// skip the read() that would return EAGAIN
+				*drained = true;
+				break;
+			}
+			if (avail > READ_CHUNK)
+				want = avail;
+		}
+	}
+	return total;
+}
+
+// == reader thread ==
+// optionally, a separate thread can read from the pty, so the child never has to wait for us while we're parsing or drawing.
+// the data is passed to the main thread through `input` (used as a lock-free queue), and `wake` is signalled when new data arrives.
+
+// an eventfd, or a pipe on other systems.
+// these are both non-blocking, and can be waited on with poll/select
+typedef struct Notifier {
+	Fd r, w;
+} Notifier;
+
+static Notifier notifier_create(void) {
+#if defined(__linux)
+	Fd fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (fd<0)
+		die("eventfd failed: %s\n", strerror(errno));
+	return (Notifier){fd, fd};
+#else
+	Fd p[2];
+	if (pipe(p)<0)
+		die("pipe failed: %s\n", strerror(errno));
+	FOR (i, 2) {
+		fcntl(p[i], F_SETFL, O_NONBLOCK);
+		fcntl(p[i], F_SETFD, FD_CLOEXEC);
+	}
+	return (Notifier){p[0], p[1]};
+#endif
+}
+
+static void notify(Notifier n) {
+	uint64_t one = 1;
+	write(n.w, &one, sizeof(one));
+}
+
+static void notifier_clear(Notifier n) {
+	uint64_t buf[16];
+#if defined(__linux)
+	read(n.r, buf, sizeof(buf));
+#else
+	while (read(n.r, buf, sizeof(buf)) > 0)
+		;
+#endif
+}
+
+static pthread_t reader;
+static Notifier wake; // reader -> main: data is available
+static Notifier room; // main -> reader: space was freed in `input`
+static atomic_bool wake_pending = false; // `wake` has been signalled and not cleared yet
+static atomic_bool reader_waiting = false; // the reader is blocked on a full buffer
+
+static void* reader_main(void* arg) {
+	while (1) {
+		size_t len;
+		utf8* span = ring_write_span(&input, &len);
+		if (len==0) {
+			// buffer is full: wait for the main thread to parse some of it
+			atomic_store(&reader_waiting, true);
+			atomic_thread_fence(memory_order_seq_cst);
+			// (check again, in case it was emptied before we set the flag)
+			if (ring_space(&input)==0)
+				poll(&(struct pollfd){.fd = room.r, .events = POLLIN}, 1, -1);
+			atomic_store(&reader_waiting, false);
+			notifier_clear(room);
+			continue;
+		}
+		ssize_t got = read(master_fd, span, len);
+		if (got>0) {
+			ring_produce(&input, got);
+			if (!atomic_exchange(&wake_pending, true))
+				notify(wake);
+		} else if (got<0 && (errno==EAGAIN || errno==EINTR)) {
+			poll(&(struct pollfd){.fd = master_fd, .events = POLLIN}, 1, -1);
+		} else {
+			// this is the normal exit condition.
+			if (got<0)
+				print("couldn't read from shell. status: \"%s\"\n", strerror(errno));
+			atomic_store(&pty_closed, true);
+			notify(wake);
+			return NULL;
+		}
+	}
+}
+
+static void start_reader(void) {
+	wake = notifier_create();
+	room = notifier_create();
+	// signals should be handled on the main thread, so block them all while the reader is created (it inherits the mask)
+	sigset_t all, old;
+	sigfillset(&all);
+	pthread_sigmask(SIG_SETMASK, &all, &old);
+	int err = pthread_create(&reader, NULL, reader_main, NULL);
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+	if (err)
+		die("failed to start reader thread: %s\n", strerror(err));
+}
+
+// parse the data queued by the reader thread
+static size_t tty_read_queue(void) {
+	Nanosec start = loop_now();
+	size_t total = 0;
+	while (1) {
+		size_t len;
+		utf8* span = ring_read_span(&input, &len);
+		if (!span) {
+			// empty: clear the notification, then check once more, in case more data came in before it was cleared
+			if (atomic_load(&wake_pending)) {
+				atomic_store(&wake_pending, false);
+				notifier_clear(wake);
+				atomic_thread_fence(memory_order_seq_cst);
+				continue;
+			}
+			break;
+		}
+		if (len > PARSE_CHUNK)
+			len = PARSE_CHUNK;
+		parse(len, span);
+		ring_consume(&input, len);
+		total += len;
+		atomic_thread_fence(memory_order_seq_cst);
+		if (atomic_load(&reader_waiting))
+			notify(room);
+		// (if we stop early, `wake` is still set, so the loop wakes up again immediately)
+		if (read_done(start, total))
+			break;
+	}
+	
+	read_more = ring_length(&input) > 0;
+	
+	if (DEBUG.read && total)
+		print("parsed %zu bytes from reader thread in %.2f ms\n", total, (loop_now()-start)/1000/1000.0);
+	
+	if (pty_closed && !ring_length(&input))
+		closed();
+	return total;
+}
+
+#ifdef USE_IO_URING
+// == io_uring ==
+// when built with USE_IO_URING (and the reader thread isn't used), the pty is read and written through io_uring instead:
+// a multishot read fills buffers from a provided buffer ring, and we parse them right where the kernel put them, then hand them back.
+// so, while a program is flooding output, a whole batch of reads costs one epoll_wait and no read() calls at all.
+// writes are copied out of `output` into a registered buffer (so the queue can still grow while they're in flight), and submitted as a chain of linked writes.
+
+#include "uring.h"
+
+// tags for the user_data field
+enum {URING_READ = 1, URING_WRITE, URING_HANGUP};
+
+static UringBuffers read_buffers;
+#define URING_BUFFERS 16
+#define URING_BUFFER_SIZE (64<<10)
+static bool multishot = true; // (set to false if the kernel doesn't support it)
+static bool read_armed = false;
+
+static utf8 staging[64<<10];
+// max size of each write in the chain
+#define WRITE_SLICE (16<<10)
+static size_t staged = 0; // bytes in `staging`
+static size_t staged_written = 0; // how many of those have been written
+static int writes_in_flight = 0;
+
+static void uring_arm_read(void) {
+	struct io_uring_sqe* sqe = uring_sqe();
+	if (!sqe)
+		return; // (we'll try again after the next batch of completions)
+	sqe->opcode = multishot ? URING_OP_READ_MULTISHOT : IORING_OP_READ;
+	sqe->fd = master_fd;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = read_buffers.group;
+	sqe->len = multishot ? 0 : read_buffers.size;
+	sqe->user_data = URING_READ;
+	read_armed = true;
+}
+
+static void uring_flush(void) {
+	if (!writes_in_flight) {
+		if (staged_written == staged) {
+			// take as much of the queue as will fit
+			staged = staged_written = 0;
+			size_t len;
+			utf8* span;
+			while (staged < sizeof(staging) && (span = ring_read_span(&output, &len))) {
+				if (len > sizeof(staging)-staged)
+					len = sizeof(staging)-staged;
+				memcpy(staging+staged, span, len);
+				ring_consume(&output, len);
+				staged += len;
+			}
+		}
+		// if one write in the chain comes up short, the rest are cancelled, and we resubmit from there once they've all completed
+		for (size_t pos = staged_written; pos < staged; ) {
+			struct io_uring_sqe* sqe = uring_sqe();
+			if (!sqe)
+				break;
+			size_t len = staged-pos < WRITE_SLICE ? staged-pos : WRITE_SLICE;
+			sqe->opcode = IORING_OP_WRITE_FIXED;
+			sqe->fd = master_fd;
+			sqe->addr = (uintptr_t)(staging+pos);
+			sqe->len = len;
+			sqe->buf_index = 0;
+			sqe->user_data = URING_WRITE;
+			pos += len;
+			if (pos < staged)
+				sqe->flags = IOSQE_IO_LINK;
+			writes_in_flight++;
+		}
+	}
+	uring_submit();
+}
+
+// handle completions
+static size_t uring_reap(void) {
+	Nanosec start = loop_now();
+	int syscalls = uring_syscalls;
+	int completions = 0;
+	size_t total = 0;
+	struct io_uring_cqe* cqe;
+	while ((cqe = uring_cqe())) {
+		int res = cqe->res;
+		unsigned flags = cqe->flags;
+		uint64_t tag = cqe->user_data;
+		uring_cqe_seen();
+		completions++;
+		if (tag==URING_READ) {
+			if (!(flags & IORING_CQE_F_MORE))
+				read_armed = false;
+			if (res>0) {
+				int id = flags >> IORING_CQE_BUFFER_SHIFT;
+				parse(res, uring_buffer(&read_buffers, id));
+				uring_buffer_recycle(&read_buffers, id);
+				total += res;
+			} else if (res==-EINVAL && multishot) {
+				// multishot reads were added in linux 6.7
+				print("io_uring: multishot read not supported, using single reads\n");
+				multishot = false;
+			} else if (res==-ENOBUFS || res==-EAGAIN || res==-EINTR) {
+				// (ran out of buffers, etc. the read is just re-armed below)
+			} else {
+				// this is the normal exit condition.
+				if (res<0)
+					print("couldn't read from shell. status: \"%s\"\n", strerror(-res));
+				pty_closed = true;
+			}
+		} else if (tag==URING_WRITE) {
+			writes_in_flight--;
+			if (res>0)
+				staged_written += res;
+			else if (res!=-ECANCELED && res!=-EAGAIN && res!=-EINTR) {
+				print("write error on tty: %s\n", strerror(-res));
+				staged_written = staged;
+				ring_consume(&output, ring_length(&output));
+			}
+		} else if (tag==URING_HANGUP) {
+			// switch to single reads, to get whatever data is left, and then the error
+			multishot = false;
+			read_armed = false;
+		}
+		// (if we stop early, the ring's fd stays readable, so the loop wakes up again immediately)
+		if (read_done(start, total))
+			break;
+	}
+	read_more = uring_cqe() != NULL;
+	if (!read_armed && !pty_closed)
+		uring_arm_read();
+	uring_flush();
+	
+	if (DEBUG.read && total)
+		print("read %zu bytes via io_uring (%d completions, %d syscalls) in %.2f ms\n", total, completions, uring_syscalls-syscalls, (loop_now()-start)/1000/1000.0);
+	
+	if (pty_closed)
+		closed();
+	return total;
+}
+
+// returns false if io_uring isn't available (then we fall back to using epoll)
+static bool uring_start(void) {
+	if (!uring_init(64))
+		return false;
+	if (!uring_register_buffer(staging, sizeof(staging)) || !uring_buffers_init(&read_buffers, 0, URING_BUFFERS, URING_BUFFER_SIZE)) {
+		uring_close();
+		return false;
 	}
-	return 0;
+	// io_uring waits for the fd to be ready by itself, but if O_NONBLOCK is set it hands us EAGAIN instead
+	fcntl(master_fd, F_SETFL, 0);
+	uring_arm_read();
+	// multishot reads don't get woken up when the child closes the pty, so we need to watch for that separately
+	struct io_uring_sqe* sqe = uring_sqe();
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = master_fd;
+	sqe->poll32_events = POLLHUP;
+	sqe->user_data = URING_HANGUP;
+	uring_submit();
+	return true;
 }
+#endif
+
+// read from child process and process the text
+// returns the number of bytes parsed
+static size_t tty_read(void) {
+	if (use_thread)
+		return tty_read_queue();
+#ifdef USE_IO_URING
+	if (use_uring)
+		return uring_reap();
+#endif
+	
+	Nanosec start = loop_now();
+	read_calls = 0;
+	size_t total = 0; // bytes read
+	size_t parsed = 0;
+	bool drained;
+	bool done = false;
+	do {
+		total += tty_fill(READ_BUDGET-total, &drained);
+		size_t len;
+		utf8* span;
+		while ((span = ring_read_span(&input, &len))) {
+			if (len > PARSE_CHUNK)
+				len = PARSE_CHUNK;
+			parse(len, span);
+			ring_consume(&input, len);
+			parsed += len;
+			// (if the pty was closed, parse everything that's left before exiting)
+			if (!pty_closed && (done = read_done(start, total)))
+				break;
+		}
+	} while (!done && !drained && !pty_closed);
+	read_more = !drained || ring_length(&input);
+	// data left in the buffer doesn't make the pty readable, so make sure we get called again
+	if (ring_length(&input))
+		loop_timer(&resume_timer, start);
+	
+	if (DEBUG.read && parsed)
+		print("read %zu bytes, parsed %zu (%d syscalls, buffer: %zu) in %.2f ms\n", total, parsed, read_calls, input.size, (loop_now()-start)/1000/1000.0);
+	
+	if (pty_closed)
+		closed();
+	return parsed;
+}
+
+// == writing ==
+// data sent to the child is queued in `output`, and written whenever the pty is writable, so we never block waiting for the child to read its input (and the parser is never re-entered from inside a write)
 
 // don't use this for anything really long
 void tty_printf(const char* format, ...) {
@@ -151,58 +638,124 @@ void tty_printf(const char* format, ...) {
 	tty_write(len, buf);
 }
 
-static int min(int a, int b) {
-	return a<b ? a : b;
+// whether the pty is being watched for writability
+PER_WINDOW static bool watching_writes = false;
+
+static void watch_writes(bool on) {
+	if (on == watching_writes)
+		return;
+	watching_writes = on;
+	if (use_thread) { // (master_fd is only used for writing on this thread)
+		if (on)
+			loop_watch(master_fd, LOOP_WRITE, on_pty_event);
+		else
+			loop_unwatch(master_fd);
+	} else
+		loop_watch(master_fd, LOOP_READ | (on ? LOOP_WRITE : 0), on_pty_event);
 }
 
-// send data to child process (i.e. keypresses)
-void tty_write(size_t len, const char str[len]) {
-	const char* pos = str;
-	fd_set write_fds, read_fds;
-	size_t lim = 256;
-	while (len > 0) {
-		// wait for uhhhh
-		FD_ZERO(&write_fds);
-		FD_ZERO(&read_fds);
-		FD_SET(master_fd, &write_fds);
-		FD_SET(master_fd, &read_fds);
-		if (pselect(master_fd+1, &read_fds, &write_fds, NULL, NULL, NULL) < 0) {
-			if (errno==EINTR || errno==EAGAIN)
+// write as much of the queue as the pty will take right now
+void tty_flush(void) {
+#ifdef USE_IO_URING
+	if (use_uring) {
+		uring_flush();
+		return;
+	}
+#endif
+	while (ring_length(&output)) {
+		// the queued data may wrap around the end of the buffer, so write both parts at once
+		struct iovec iov[2];
+		size_t len;
+		iov[0].iov_base = ring_read_span(&output, &len);
+		iov[0].iov_len = len;
+		iov[1].iov_base = output.data;
+		iov[1].iov_len = ring_length(&output) - len;
+		ssize_t written = writev(master_fd, iov, iov[1].iov_len ? 2 : 1);
+		if (written < 0) {
+			if (errno==EINTR)
 				continue;
-			die("select failed: %s\n", strerror(errno));
-		}
-		
-		if (FD_ISSET(master_fd, &write_fds)) {
-			// Only write the bytes written by ttywrite() or the
-			// default of 256. This seems to be a reasonable value
-			// for a serial line. Bigger values might clog the I/O.
-			ssize_t written = write(master_fd, pos, min(len, lim));
-			if (written < 0) {
-				die("write error on tty: %s\n", strerror(errno));
-			} else if (written >= len) {
-				// finished
+			if (errno==EAGAIN)
 				break;
-			} else {
-				// We weren't able to write out everything.
-				// This means the buffer is getting full
-				// again. Empty it.
-				if (len < lim)
-					lim = tty_read();
-				len -= written;
-				pos += written;
-			}
+			// (the child probably exited. this will be noticed on the read side)
+			print("write error on tty: %s\n", strerror(errno));
+			ring_consume(&output, ring_length(&output));
+			break;
+		}
+		if (written > len) {
+			ring_consume(&output, len);
+			written -= len;
 		}
-		if (FD_ISSET(master_fd, &read_fds))
-			lim = tty_read();
+		ring_consume(&output, written);
 	}
+	watch_writes(ring_length(&output) > 0);
+}
+
+// send data to child process (i.e. keypresses)
+// this never blocks: the data is queued, and written by tty_flush() from the main loop (so several small writes get combined)
+static void queue(size_t len, const void* data) {
+	const utf8* str = data;
+	while (len > 0) {
+		size_t space;
+		utf8* span = ring_write_span(&output, &space);
+		if (space > len)
+			space = len;
+		memcpy(span, str, space);
+		ring_produce(&output, space);
+		str += space;
+		len -= space;
+	}
+}
+
+void tty_write(size_t len, const char str[len]) {
+	latency_write();
+	// (when attached to a session, each write is sent as a message)
+	size_t header = attached ? sizeof(SessionHeader) : 0;
+	if (!ring_reserve(&output, header+len, WRITE_MAX)) {
+		print("tty output queue is full! dropping %zu bytes\n", len);
+		return;
+	}
+	if (attached)
+		queue(header, &(SessionHeader){.type = SESSION_INPUT, .length = len});
+	queue(len, str);
+}
+
+// whether the output queue is past the high-water mark
+// (things that send a lot of data (i.e. pasting) should wait until this is false)
+bool tty_write_busy(void) {
+	size_t queued = ring_length(&output);
+#ifdef USE_IO_URING
+	queued += staged - staged_written;
+#endif
+	return queued >= WRITE_HIGH_WATER;
 }
 
 void tty_hangup(void) {
 	//signal(SIGCHLD, SIG_DFL);
-	kill(child_pid, SIGHUP);
+	// (when attached to a session, the child keeps running. the window just detaches)
+	if (!attached)
+		kill(child_pid, SIGHUP);
+}
+
+// hang up, and release everything (for daemon mode, where the process keeps running after the window is closed)
+void tty_close(void) {
+	// (if the pty was closed, the child has probably exited and been reaped already, so its pid could belong to something else now)
+	if (!pty_closed)
+		tty_hangup();
+	loop_unwatch(master_fd);
+	close(master_fd);
+	ring_free(&input);
+	ring_free(&output);
 }
 
 void tty_resize(int w, int h, Px pw, Px ph) {
+	record_resize(w, h, pw, ph);
+	if (attached) {
+		if (ring_reserve(&output, sizeof(SessionHeader)+sizeof(SessionResize), WRITE_MAX)) {
+			queue(sizeof(SessionHeader), &(SessionHeader){.type = SESSION_RESIZE, .length = sizeof(SessionResize)});
+			queue(sizeof(SessionResize), &(SessionResize){w, h, pw, ph});
+		}
+		return;
+	}
 	// TIOCSWINSZ = T? IOCtl() Set WINdow SiZe
 	if (ioctl(master_fd, TIOCSWINSZ, &(struct winsize){
 		.ws_col = w,
@@ -213,32 +766,47 @@ void tty_resize(int w, int h, Px pw, Px ph) {
 		print("Couldn't set window size: %s\n", strerror(errno));
 }
 
-static int max(int a, int b) {
-	if (a>b)
-		return a;
-	return b;
+// set a function to call when the child exits (instead of just exiting)
+void tty_on_close(void (*func)(void)) {
+	on_close = func;
 }
 
-//wait until data is recieved on either master_fd (the fd used to communicate with the child) OR xfd (notifies when x events are recieved)
-// returns true if data was recvd on master_fd
-bool tty_wait(Fd xfd, Nanosec timeout) {
-	fd_set rfd;
-	while (1) {
-		FD_ZERO(&rfd);
-		FD_SET(master_fd, &rfd);
-		FD_SET(xfd, &rfd);
-		
-		struct timespec seltv = {
-			.tv_sec = timeout/(1000*1000*1000),
-			.tv_nsec = timeout % (1000*1000*1000),
-		};
-		struct timespec* tv = timeout>=0 ? &seltv : NULL;
-		
-		if (pselect(max(xfd, master_fd)+1, &rfd, NULL, NULL, tv, NULL) < 0) {
-			if (!(errno==EINTR || errno==EAGAIN))
-				die("select failed: %s\n", strerror(errno));
-		} else
-			break;
+// set how long a single call to tty_read() may spend parsing
+void tty_set_read_budget(Nanosec budget) {
+	read_time_budget = budget;
+}
+
+// set a function which is called between chunks of parsing, and returns true if tty_read() should stop early to let something else run (i.e. to handle user input)
+void tty_set_yield(bool (*func)(void)) {
+	yield = func;
+}
+
+PER_WINDOW static void (*on_read)(size_t bytes, bool more);
+
+static void on_pty_event(Fd fd, int events) {
+	if (events & LOOP_WRITE)
+		tty_flush();
+	if (events & LOOP_READ) {
+		size_t bytes = tty_read();
+		if (bytes && on_read)
+			on_read(bytes, read_more);
 	}
-	return FD_ISSET(master_fd, &rfd);
+}
+
+static void resume_read(void) {
+	on_pty_event(master_fd, LOOP_READ);
+}
+
+// start handling pty events in the main loop
+// `func` is called whenever new data has been read and parsed
+// (`more` is set if it stopped early because it ran out of time, and there's more data waiting)
+void tty_watch(void (*func)(size_t bytes, bool more)) {
+	on_read = func;
+	// when the reader thread is running, it signals `wake` instead of us watching the pty directly
+	Fd fd = use_thread ? wake.r : master_fd;
+#ifdef USE_IO_URING
+	if (use_uring)
+		fd = uring_fd();
+#endif
+	loop_watch(fd, LOOP_READ, on_pty_event);
 }
@@ -2,12 +2,16 @@
 
 #include "common.h"
 
-typedef int Fd;
-
 void tty_init(void);
-size_t tty_read(void);
 void tty_write(size_t n, const utf8 str[n]);
+void tty_flush(void);
+bool tty_write_busy(void);
 void tty_printf(const utf8* format, ...);
 void tty_hangup(void);
+void tty_close(void);
 void tty_resize(int w, int h, Px pw, Px ph);
-bool tty_wait(Fd xfd, Nanosec timeout);
+void tty_watch(void (*func)(size_t bytes, bool more));
+void tty_set_read_budget(Nanosec budget);
+void tty_set_yield(bool (*func)(void));
+void tty_attach(Fd fd);
+void tty_on_close(void (*func)(void));
@@ -0,0 +1,182 @@
+// Minimal io_uring interface
+// this uses the raw syscalls, so we don't need liburing.
+// only the parts needed by tty.c are here: submitting/reaping, one registered (fixed) buffer, and provided buffer rings
+
+#define _DEFAULT_SOURCE
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <stdatomic.h>
+
+#include "common.h"
+#include "uring.h"
+
+int uring_syscalls = 0;
+
+static struct uring {
+	Fd fd;
+	// submission queue
+	_Atomic unsigned* sq_head;
+	_Atomic unsigned* sq_tail;
+	unsigned sq_mask, sq_entries;
+	unsigned* sq_array;
+	struct io_uring_sqe* sqes;
+	unsigned sq_local_tail; // includes sqes which have been prepared but not submitted yet
+	// completion queue
+	_Atomic unsigned* cq_head;
+	_Atomic unsigned* cq_tail;
+	unsigned cq_mask;
+	struct io_uring_cqe* cqes;
+} U = {.fd = -1};
+
+// returns false if io_uring isn't available
+bool uring_init(unsigned entries) {
+	struct io_uring_params p = {0};
+	U.fd = syscall(__NR_io_uring_setup, entries, &p);
+	uring_syscalls++;
+	if (U.fd<0) {
+		print("io_uring_setup failed: %s\n", strerror(errno));
+		return false;
+	}
+	size_t sq_size = p.sq_off.array + p.sq_entries*sizeof(unsigned);
+	size_t cq_size = p.cq_off.cqes + p.cq_entries*sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		if (cq_size > sq_size)
+			sq_size = cq_size;
+		cq_size = sq_size;
+	}
+	uint8_t* sq = mmap(NULL, sq_size, PROT_READ|PROT_WRITE, MAP_SHARED, U.fd, IORING_OFF_SQ_RING);
+	uint8_t* cq = sq;
+	if (!(p.features & IORING_FEAT_SINGLE_MMAP))
+		cq = mmap(NULL, cq_size, PROT_READ|PROT_WRITE, MAP_SHARED, U.fd, IORING_OFF_CQ_RING);
+	U.sqes = mmap(NULL, p.sq_entries*sizeof(struct io_uring_sqe), PROT_READ|PROT_WRITE, MAP_SHARED, U.fd, IORING_OFF_SQES);
+	if (sq==MAP_FAILED || cq==MAP_FAILED || U.sqes==MAP_FAILED) {
+		print("io_uring mmap failed: %s\n", strerror(errno));
+		close(U.fd);
+		U.fd = -1;
+		return false;
+	}
+	U.sq_head = (void*)(sq + p.sq_off.head);
+	U.sq_tail = (void*)(sq + p.sq_off.tail);
+	U.sq_mask = *(unsigned*)(sq + p.sq_off.ring_mask);
+	U.sq_entries = p.sq_entries;
+	U.sq_array = (void*)(sq + p.sq_off.array);
+	U.sq_local_tail = atomic_load(U.sq_tail);
+	U.cq_head = (void*)(cq + p.cq_off.head);
+	U.cq_tail = (void*)(cq + p.cq_off.tail);
+	U.cq_mask = *(unsigned*)(cq + p.cq_off.ring_mask);
+	U.cqes = (void*)(cq + p.cq_off.cqes);
+	return true;
+}
+
+// the ring's fd becomes readable when there are completions waiting
+Fd uring_fd(void) {
+	return U.fd;
+}
+
+// get a (zeroed) submission entry to fill in, or NULL if the queue is full
+// it'll be sent on the next uring_submit()
+struct io_uring_sqe* uring_sqe(void) {
+	unsigned head = atomic_load_explicit(U.sq_head, memory_order_acquire);
+	if (U.sq_local_tail - head >= U.sq_entries)
+		return NULL;
+	unsigned index = U.sq_local_tail & U.sq_mask;
+	U.sq_array[index] = index;
+	U.sq_local_tail++;
+	struct io_uring_sqe* sqe = &U.sqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+	return sqe;
+}
+
+// submit all prepared entries (without waiting for anything)
+int uring_submit(void) {
+	unsigned count = U.sq_local_tail - atomic_load_explicit(U.sq_tail, memory_order_relaxed);
+	if (!count)
+		return 0;
+	atomic_store_explicit(U.sq_tail, U.sq_local_tail, memory_order_release);
+	int ret;
+	do {
+		ret = syscall(__NR_io_uring_enter, U.fd, count, 0, 0, NULL, 0);
+		uring_syscalls++;
+	} while (ret<0 && errno==EINTR);
+	if (ret<0)
+		print("io_uring_enter failed: %s\n", strerror(errno));
+	return ret;
+}
+
+// get the next completion, or NULL if there are none
+// call uring_cqe_seen() when you're done with it
+struct io_uring_cqe* uring_cqe(void) {
+	unsigned head = atomic_load_explicit(U.cq_head, memory_order_relaxed);
+	if (head == atomic_load_explicit(U.cq_tail, memory_order_acquire))
+		return NULL;
+	return &U.cqes[head & U.cq_mask];
+}
+
+void uring_cqe_seen(void) {
+	atomic_fetch_add_explicit(U.cq_head, 1, memory_order_release);
+}
+
+// register a buffer to be used with IORING_OP_WRITE_FIXED/READ_FIXED (buf_index 0)
+bool uring_register_buffer(void* data, size_t size) {
+	struct iovec iov = {data, size};
+	uring_syscalls++;
+	if (syscall(__NR_io_uring_register, U.fd, IORING_REGISTER_BUFFERS, &iov, 1) < 0) {
+		print("io_uring buffer registration failed: %s\n", strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+// set up `count` buffers of `size` bytes each, as buffer group `group`
+bool uring_buffers_init(UringBuffers* b, int group, int count, unsigned size) {
+	*b = (UringBuffers){
+		.count = count,
+		.size = size,
+		.group = group,
+	};
+	// the ring has to be page aligned, so we use mmap
+	b->ring = mmap(NULL, count*sizeof(struct io_uring_buf), PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+	if (b->ring==MAP_FAILED)
+		return false;
+	struct io_uring_buf_reg reg = {
+		.ring_addr = (uintptr_t)b->ring,
+		.ring_entries = count,
+		.bgid = group,
+	};
+	uring_syscalls++;
+	if (syscall(__NR_io_uring_register, U.fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+		print("io_uring provided buffer registration failed: %s\n", strerror(errno));
+		munmap(b->ring, count*sizeof(struct io_uring_buf));
+		return false;
+	}
+	ALLOC(b->data, (size_t)count*size);
+	if (!b->data)
+		die("io_uring buffer allocation failed\n");
+	FOR (i, count)
+		uring_buffer_recycle(b, i);
+	return true;
+}
+
+utf8* uring_buffer(UringBuffers* b, int id) {
+	return b->data + (size_t)id*b->size;
+}
+
+// give a buffer back to the kernel, once we're done with its data
+void uring_buffer_recycle(UringBuffers* b, int id) {
+	struct io_uring_buf* buf = &b->ring->bufs[b->tail & b->count-1];
+	buf->addr = (uintptr_t)uring_buffer(b, id);
+	buf->len = b->size;
+	buf->bid = id;
+	b->tail++;
+	// (the tail field overlaps the first entry's reserved field)
+	atomic_store_explicit((_Atomic uint16_t*)&b->ring->tail, b->tail, memory_order_release);
+}
+
+void uring_close(void) {
+	close(U.fd);
+	U.fd = -1;
+}
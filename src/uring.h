@@ -0,0 +1,33 @@
+#pragma once
+// Minimal io_uring interface (only built with USE_IO_URING)
+
+#include <linux/io_uring.h>
+
+#include "common.h"
+
+// (these aren't in older kernel headers)
+#define URING_OP_READ_MULTISHOT 49
+
+// a ring of "provided buffers": the kernel picks a free one for each read, and returns its id in the completion
+typedef struct UringBuffers {
+	struct io_uring_buf_ring* ring;
+	utf8* data;
+	int count; // power of 2
+	unsigned size; // size of each buffer
+	uint16_t tail;
+	int group;
+} UringBuffers;
+
+bool uring_init(unsigned entries);
+void uring_close(void);
+Fd uring_fd(void);
+struct io_uring_sqe* uring_sqe(void);
+int uring_submit(void);
+struct io_uring_cqe* uring_cqe(void);
+void uring_cqe_seen(void);
+bool uring_register_buffer(void* data, size_t size);
+bool uring_buffers_init(UringBuffers* b, int group, int count, unsigned size);
+utf8* uring_buffer(UringBuffers* b, int id);
+void uring_buffer_recycle(UringBuffers* b, int id);
+
+extern int uring_syscalls;
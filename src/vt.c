@@ -0,0 +1,92 @@
+// Callbacks used by the emulator core (see vt.h)
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "common.h"
+#include "vt.h"
+#include "settings.h"
+
+VtCallbacks vt;
+
+// for programs that only use the core
+// (12term itself loads the settings, and calls init_term directly)
+void vt_init(int width, int height) {
+	init_default_palette();
+	init_term(width, height);
+}
+
+void vt_printf(const utf8* format, ...) {
+	if (!vt.write)
+		return;
+	va_list ap;
+	va_start(ap, format);
+	utf8 buf[1024];
+	int len = vsnprintf(buf, LEN(buf), format, ap);
+	va_end(ap);
+	if (len > (int)LEN(buf)-1)
+		len = LEN(buf)-1;
+	vt.write(len, buf);
+}
+
+void vt_dirty_all(void) {
+	if (vt.dirty_all)
+		vt.dirty_all();
+}
+
+void vt_rotate_rows(int y1, int y2, int amount, bool screen_space) {
+	if (vt.rotate_rows)
+		vt.rotate_rows(y1, y2, amount, screen_space);
+}
+
+void vt_free_image(struct Image* image) {
+	if (vt.free_image)
+		vt.free_image(image);
+}
+
+// parse `digits` hex digits, scaled to 0-255
+static bool parse_hex(const utf8* s, int digits, uint8_t* out) {
+	int value = 0;
+	FOR (i, digits) {
+		if (!isxdigit(s[i]))
+			return false;
+		value = value*16 + (isdigit(s[i]) ? s[i]-'0' : tolower(s[i])-'a'+10);
+	}
+	*out = value * 255 / ((1<<4*digits)-1);
+	return true;
+}
+
+bool vt_parse_color(const utf8* spec, RGBColor* out) {
+	if (vt.parse_color)
+		return vt.parse_color(spec, out);
+	RGBColor c;
+	if (spec[0]=='#') {
+		// #rgb, #rrggbb, etc.
+		size_t len = strcspn(spec+1, ";");
+		if (len==0 || len%3 || len>12)
+			return false;
+		int d = len/3;
+		if (!parse_hex(spec+1, d, &c.r) || !parse_hex(spec+1+d, d, &c.g) || !parse_hex(spec+1+2*d, d, &c.b))
+			return false;
+	} else if (!strncmp(spec, "rgb:", 4)) {
+		// rgb:r/g/b, with 1-4 digits per component
+		const utf8* s = spec+4;
+		uint8_t* parts[3] = {&c.r, &c.g, &c.b};
+		FOR (i, 3) {
+			int d = strcspn(s, "/;");
+			if (d<1 || d>4 || !parse_hex(s, d, parts[i]))
+				return false;
+			s += d;
+			if (i<2) {
+				if (*s!='/')
+					return false;
+				s++;
+			}
+		}
+	} else
+		return false;
+	*out = c;
+	return true;
+}
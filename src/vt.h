@@ -0,0 +1,42 @@
+#pragma once
+// libvt: the terminal emulator core (parser + screen buffer), without X
+// (build it with `make libvt.a`)
+// usage: fill in `vt` with your callbacks, call vt_init(), then pass the child's output to process_chars().
+// the screen contents are in `T` (see buffer.h)
+
+#include "common.h"
+#include "buffer.h"
+#include "ctlseqs.h"
+
+struct Image; // (image.h)
+
+// everything the emulator does outside of the screen buffer goes through these.
+// any of them can be left NULL
+typedef struct VtCallbacks {
+	// set the window title (NULL = reset to default)
+	void (*set_title)(utf8* title);
+	// set a selection. `data` is malloc'd, and the callback is responsible for freeing it
+	void (*own_clipboard)(utf8* which, utf8* data);
+	void (*change_font)(const utf8* name);
+	// redraw hints: all cells have changed
+	void (*dirty_all)(void);
+	// rows y1 to y2 were scrolled by `amount` (screen_space: relative to the screen rather than the buffer (i.e. scrollback))
+	void (*rotate_rows)(int y1, int y2, int amount, bool screen_space);
+	// send data back to the child (i.e. responses to queries)
+	void (*write)(size_t len, const utf8 data[len]);
+	// parse a color name/spec. if this isn't set, only the `#rrggbb` and `rgb:rr/gg/bb` forms are supported
+	bool (*parse_color)(const utf8* spec, RGBColor* out);
+	// an image is about to be freed (see image.h), so anything the frontend made from it should be released
+	void (*free_image)(struct Image* image);
+} VtCallbacks;
+
+extern VtCallbacks vt;
+
+void vt_init(int width, int height);
+
+// these are used by the core to call the callbacks
+void vt_printf(const utf8* format, ...) __attribute__((format(printf, 1, 2)));
+bool vt_parse_color(const utf8* spec, RGBColor* out);
+void vt_dirty_all(void);
+void vt_rotate_rows(int y1, int y2, int amount, bool screen_space);
+void vt_free_image(struct Image* image);
@@ -6,7 +6,7 @@
 #include <locale.h>
 #include <errno.h>
 #include <fcntl.h>
-#include <time.h>
+#include <poll.h>
 #ifdef CATCH_SEGFAULT
 # include <signal.h>
 # define __USE_GNU
@@ -16,6 +16,7 @@
 #include <X11/Xlib.h>
 #include <X11/Xatom.h>
 #include <X11/Xresource.h>
+#include <fontconfig/fontconfig.h>
 
 #include "common.h"
 #include "tty.h"
@@ -25,11 +26,21 @@
 #include "event.h"
 #include "settings.h"
 #include "icon.h"
+#include "loop.h"
+#include "paste.h"
+#include "record.h"
+#include "vt.h"
+#include "frame.h"
+#include "latency.h"
+#include "clipboard.h"
+#include "draw2.h"
+#include "daemon.h"
+#include "session.h"
 
 #include "xft/Xft.h"
 //#include "lua.h"
 
-Xw W = {0};
+PER_WINDOW Xw W = {0};
 
 static unsigned long alloc_color(Color c) {
 	XRenderColor x = make_color(c);
@@ -85,6 +96,8 @@ void change_size(Px w, Px h, bool charsize, bool resize) {
 			XResizeWindow(W.d, W.win, W.w, W.h);
 	}
 	tty_resize(width, height, width*W.cw, height*W.ch);
+	T.cell_width = W.cw;
+	T.cell_height = W.ch;
 	term_resize(width, height);
 	draw_resize(width, height, charsize);
 }
@@ -95,6 +108,9 @@ __attribute__((noreturn)) void sleep_forever(bool hangup) {
 	//if (hangup)
 	tty_hangup();
 	
+	record_close();
+	latency_dump();
+	
 	fonts_free();
 	
 	draw_free();
@@ -112,76 +128,136 @@ void clipboard_copy() {
 	
 }
 
-static bool redraw = false;
+// set when the window is closed, or its child exits (in daemon mode)
+PER_WINDOW static bool closing = false;
+
+// called when the window is closed, or the child exits
+// (in daemon mode, only this window goes away: it's destroyed by the daemon afterwards (see destroy_window()). otherwise, we exit)
+void close_window(bool hangup) {
+	if (in_daemon) {
+		closing = true;
+		return;
+	}
+	sleep_forever(hangup);
+}
+
+bool window_closing(void) {
+	return closing;
+}
+
+PER_WINDOW static bool redraw = false;
 
 void force_redraw(void) {
 	redraw = true;
 }
 
-static Nanosec timediff(struct timespec t1, struct timespec t2) {
-	return (t1.tv_sec-t2.tv_sec)*1000L*1000*1000 + (t1.tv_nsec-t2.tv_nsec);
+// wakes up the main loop when it's time to draw the next frame
+PER_WINDOW static Timer frame_timer;
+
+// during a synchronized update (see T.synchronized), frames are held back until it ends, or this much time has passed (in case the program never ends it)
+#define SYNC_TIMEOUT (150*1000*1000)
+PER_WINDOW static Nanosec sync_start = 0; // when the current synchronized update began
+PER_WINDOW static bool sync_done = false; // a synchronized update just ended, so draw the result right away
+
+PER_WINDOW static Nanosec last_redraw = 0;
+
+// nothing is drawn until the window is mapped (that's when we know its real size)
+PER_WINDOW static bool mapped = false;
+PER_WINDOW static Px map_w, map_h;
+
+static void on_tty_read(size_t bytes, bool more) {
+	redraw = true;
+	frame_output(bytes, more);
 }
 
-static Nanosec min_redraw = 10*1000*1000;
+// called between chunks of parsing: stop early if there's user input waiting, so it doesn't get stuck behind a flood of output
+static bool x_input_pending(void) {
+	if (XEventsQueued(W.d, QueuedAlready))
+		return true;
+	return poll(&(struct pollfd){.fd = XConnectionNumber(W.d), .events = POLLIN}, 1, 0) > 0;
+}
 
-// todo: clean this up
-static void run(void) {
-	XMapWindow(W.d, W.win);
-	
-	XEvent ev;
-	int w = W.w, h = W.h;
-	do {
-		XNextEvent(W.d, &ev);
-		if (XFilterEvent(&ev, None))
-			continue;
-		if (ev.type == ConfigureNotify) {
-			w = ev.xconfigure.width;
-			h = ev.xconfigure.height;
+// handle an event for our window (XFilterEvent() should be called first)
+void handle_event(XEvent* ev) {
+	if (!mapped) {
+		if (ev->type == ConfigureNotify) {
+			map_w = ev->xconfigure.width;
+			map_h = ev->xconfigure.height;
+		} else if (ev->type == MapNotify) {
+			mapped = true;
+			change_size(map_w, map_h, true, false);
+			
+			time_log("window mapped");
+			
+			//init_lua();
+			//time_log("lua");
+			
+			tty_watch(on_tty_read);
+			tty_set_yield(x_input_pending);
 		}
-	} while (ev.type != MapNotify);
-	
-	change_size(w, h, true, false);
-	
-	time_log("window mapped");
+		return;
+	}
+	if (HANDLERS[ev->type])
+		(HANDLERS[ev->type])(ev);
+	// send keypresses right away, rather than waiting until after the next frame is drawn
+	if (ev->type==KeyPress)
+		tty_flush();
+}
+
+// called after each round of events: draw a frame if it's time, and send input to the child
+void update_window(void) {
+	if (!mapped)
+		return;
+	
+	if (T.synchronized) {
+		if (!sync_start)
+			sync_start = loop_now();
+	} else if (sync_start) {
+		sync_start = 0;
+		sync_done = true;
+	}
 	
-	//init_lua();
-	//time_log("lua");
+	if (redraw) {
+		Nanosec now = loop_now();
+		Nanosec next = frame_next(last_redraw);
+		if (sync_start && now-sync_start < SYNC_TIMEOUT)
+			next = sync_start+SYNC_TIMEOUT;
+		else if (sync_done)
+			next = now;
+		if (now >= next) {
+			draw(false);
+			redraw = false;
+			sync_done = false;
+			last_redraw = now;
+			frame_drawn(loop_now()-now);
+		} else {
+			loop_timer(&frame_timer, next);
+			//print("delaying redraw for %lld ms\n", (next-now)/1000/1000);
+		}
+	}
+	tty_set_read_budget(frame_parse_budget());
 	
-	Fd xfd = XConnectionNumber(W.d);
+	paste_pump();
 	
-	struct timespec last_redraw = {0};
+	// send everything that was written to the tty during this iteration (keypresses, responses to queries, etc.) at once
+	tty_flush();
+}
+
+// todo: clean this up
+static void run(void) {
+	// (x events are handled below, we just need to wake up when they arrive)
+	loop_watch(XConnectionNumber(W.d), LOOP_READ, NULL);
 	
+	XEvent ev;
 	while (1) {
-		if (tty_read()) {
-			redraw = true;
-		}
-		
 		while (XPending(W.d)) {
 			XNextEvent(W.d, &ev);
 			if (XFilterEvent(&ev, None))
 				continue;
-			if (HANDLERS[ev.type])
-				(HANDLERS[ev.type])(&ev);
+			handle_event(&ev);
 		}
-		
-		Nanosec timeout = (Nanosec)10000*1000*1000;
-		
-		if (redraw) {
-			struct timespec now;
-			clock_gettime(CLOCK_MONOTONIC, &now);
-			Nanosec since_last = timediff(now, last_redraw);
-			//print("since last: %lld", since_last/1000/1000);
-			if (since_last>=min_redraw) {
-				draw(false);
-				redraw = false;
-				last_redraw = now;
-			} else {
-				timeout = min_redraw - since_last + 1000;
-				//print("delaying redraw for %lld ms\n", timeout/1000/1000);
-			}
-		}
-		
-		tty_wait(xfd, XPending(W.d) ? 0 : timeout);
+		update_window();
+		loop_wait(!XPending(W.d));
 	}
 }
 
@@ -245,15 +321,22 @@ int main(int argc, char* argv[argc+1]) {
 		print("%s\n", argv[i]);
 	}
 	
+	bool daemon = false;
+	if (argc>1) {
+		if (!strcmp(argv[1], "-c") || !strcmp(argv[1], "--client")) {
+			if (daemon_client())
+				return 0;
+			print("daemon isn't running, starting normally\n");
+		} else if (!strcmp(argv[1], "-d") || !strcmp(argv[1], "--daemon"))
+			daemon = true;
+	}
+	
 	// hecking locale
 	setlocale(LC_ALL, "");
 	XSetLocaleModifiers("");
 	
 	time_log("set locale");
 	
-	int w = settings.width;
-	int h = settings.height;
-	
 	W.border = 3;
 	
 	W.d = XOpenDisplay(NULL);
@@ -295,23 +378,79 @@ int main(int argc, char* argv[argc+1]) {
 	
 	time_log("load settings");
 	
-	tty_init(); // todo: maybe try to pass the window size here if we can guess it?
+	font_init();
+	time_log("init font libraries");
+	
+	load_fonts(settings.faceName, settings.faceSize);
 	
-	time_log("init tty");
+	time_log("load fonts");
+	
+	vt = (VtCallbacks){
+		.set_title = set_title,
+		.own_clipboard = own_clipboard,
+		.change_font = change_font,
+		.dirty_all = dirty_all,
+		.rotate_rows = draw_rotate_rows,
+		.write = tty_write,
+		.parse_color = parse_x_color,
+		.free_image = draw_free_image,
+	};
+	
+	if (daemon) {
+		// render the rest of ascii, while we have time
+		FOR (style, 4)
+			for (Char c=' '; c<='~'; c++)
+				cache_lookup(c, style);
+		daemon_run(); // doesn't return
+	}
+	
+	open_window();
+	run();
+	return 0;
+}
+
+PER_WINDOW static Pixmap icon_pixmap = None;
+
+// create a terminal: start the child process (or attach to a session) and create its window
+// (in daemon mode, this is called once per client, with the client's environment and cwd)
+void open_window(void) {
+	int w = settings.width;
+	int h = settings.height;
 	
 	init_term(w, h); // todo: we are going to get a term_resize event quickly after this, mmm.. idk if this is the right place for this, also. I mostly just put it here to simplify the timing logs
 	
 	time_log("init term");
 	
-	font_init();
+	// attach to a detachable session (see session.c)
+	// (this happens before the callbacks are set, since the window doesn't exist yet)
+	Fd session = -1;
+	utf8* session_name = getenv("SESSION_12TERM");
+	if (session_name && session_name[0]) {
+		session = session_connect(session_name, XConnectionNumber(W.d));
+		w = T.width;
+		h = T.height;
+	}
 	
-	time_log("init font libraries");
-		
-	load_fonts(settings.faceName, settings.faceSize);
+	loop_init();
+	
+	// (these are process-wide, so they're skipped in daemon mode)
+	if (!in_daemon) {
+		record_init();
+		latency_init();
+	}
+	
+	if (session>=0)
+		tty_attach(session);
+	else
+		tty_init(); // todo: maybe try to pass the window size here if we can guess it?
+	
+	time_log("init tty");
 	
 	// messy messy
 	W.w = W.cw*w+W.border*2;
 	W.h = W.ch*h+W.border*2;
+	map_w = W.w;
+	map_h = W.h;
 	
 	// create the window
 	
@@ -353,12 +492,12 @@ int main(int argc, char* argv[argc+1]) {
 		.res_name = "12term",
 		.res_class = "12term",
 	});
-	set_title(NULL);
+	set_title(session_title());
 	
 	// set icon
 	// todo: make this work on other screen depths!
 	if (XDefaultDepth(W.d, W.scr) == 24) {
-		Pixmap icon_pixmap = XCreatePixmap(W.d, W.win, ICON_SIZE, ICON_SIZE, 24);
+		icon_pixmap = XCreatePixmap(W.d, W.win, ICON_SIZE, ICON_SIZE, 24);
 		XImage* icon_image = XCreateImage(W.d, W.vis, 24, ZPixmap, 0, (void*)ICON_DATA, ICON_SIZE, ICON_SIZE, 8, 0);
 		icon_image->f.destroy_image = gosh_dang_destroy_image_function;
 		XPutImage(W.d, icon_pixmap, W.gc, icon_image, 0,0,0,0, icon_image->width, icon_image->height);
@@ -382,11 +521,33 @@ int main(int argc, char* argv[argc+1]) {
 	
 	time_log("init input");
 	
-	run();
-	return 0;
+	XMapWindow(W.d, W.win);
 }
 
+// free everything belonging to the current window (daemon mode only: otherwise we just exit)
+void destroy_window(void) {
+	tty_close();
+	image_delete_all();
+	draw_free();
+	free_input();
+	paste_free();
+	clipboard_free();
+	parser_free();
+	term_free();
+	if (icon_pixmap)
+		XFreePixmap(W.d, icon_pixmap);
+	XFreeGC(W.d, W.gc);
+	XDestroyWindow(W.d, W.win);
+	loop_free();
+}
+
+
 void change_font(const utf8* name) {
+	// the fonts are shared by every window in the daemon
+	if (in_daemon) {
+		print("can't change font in daemon mode\n");
+		return;
+	}
 	load_fonts(name, settings.faceSize);
 	int w = W.cw*T.width+W.border*2;
 	int h = W.ch*T.height+W.border*2;
@@ -46,6 +46,14 @@ typedef struct Xw {
 extern Xw W;
 
 __attribute__((noreturn)) void sleep_forever(bool hangup);
+void close_window(bool hangup);
+bool window_closing(void);
+void open_window(void);
+void destroy_window(void);
+void handle_event(XEvent* ev);
+void update_window(void);
 void clippaste(void);
 void change_size(int width, int height, bool charsize, bool do_resize);
 void force_redraw(void);
+void set_title(utf8* s);
+void change_font(const utf8* name);